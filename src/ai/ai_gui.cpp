@@ -32,6 +32,7 @@
 #include "ai.hpp"
 #include "ai_gui.hpp"
 #include "../script/api/script_log.hpp"
+#include "../script/squirrel.hpp"
 #include "ai_config.hpp"
 #include "ai_info.hpp"
 #include "ai_instance.hpp"
@@ -1200,6 +1201,19 @@ struct AIDebugWindow : public Window {
 		this->last_vscroll_pos = this->vscroll->GetPosition();
 	}
 
+	/**
+	 * Set the string parameters for the memory usage of a script.
+	 * @param offset First string parameter to set.
+	 * @param stats Allocator statistics of the script.
+	 */
+	static void SetAllocatorStatsDParams(uint offset, const ScriptAllocatorStats &stats)
+	{
+		const uint64 total_allocations = stats.small_allocations + stats.large_allocations;
+		SetDParam(offset, stats.allocated_size);
+		SetDParam(offset + 1, stats.slab_reserved);
+		SetDParam(offset + 2, total_allocations > 0 ? (stats.small_allocations * 100) / total_allocations : 0);
+	}
+
 	void SetStringParameters(int widget) const override
 	{
 		switch (widget) {
@@ -1207,17 +1221,20 @@ struct AIDebugWindow : public Window {
 				if (ai_debug_company == OWNER_DEITY) {
 					const GameInfo *info = Game::GetInfo();
 					assert(info != nullptr);
-					SetDParam(0, STR_AI_DEBUG_NAME_AND_VERSION);
+					SetDParam(0, STR_AI_DEBUG_NAME_VERSION_AND_MEMORY);
 					SetDParamStr(1, info->GetName());
 					SetDParam(2, info->GetVersion());
+					SetAllocatorStatsDParams(3, Game::GetInstance()->GetAllocatorStats());
 				} else if (ai_debug_company == INVALID_COMPANY || !Company::IsValidAiID(ai_debug_company)) {
 					SetDParam(0, STR_EMPTY);
 				} else {
-					const AIInfo *info = Company::Get(ai_debug_company)->ai_info;
+					const Company *c = Company::Get(ai_debug_company);
+					const AIInfo *info = c->ai_info;
 					assert(info != nullptr);
-					SetDParam(0, STR_AI_DEBUG_NAME_AND_VERSION);
+					SetDParam(0, STR_AI_DEBUG_NAME_VERSION_AND_MEMORY);
 					SetDParamStr(1, info->GetName());
 					SetDParam(2, info->GetVersion());
+					SetAllocatorStatsDParams(3, c->ai_instance->GetAllocatorStats());
 				}
 				break;
 		}
@@ -1431,6 +1448,12 @@ struct AIDebugWindow : public Window {
 				(ai_debug_company == OWNER_DEITY ? !Game::IsPaused() : !AI::IsPaused(ai_debug_company)));
 	}
 
+	void OnHundredthTick() override
+	{
+		/* Refresh the memory usage of the script. */
+		this->SetWidgetDirty(WID_AID_NAME_TEXT);
+	}
+
 	void OnResize() override
 	{
 		this->vscroll->SetCapacityFromWidget(this, WID_AID_LOG_PANEL);
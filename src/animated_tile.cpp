@@ -16,12 +16,46 @@
 #include "framerate_type.h"
 #include "date_func.h"
 #include "3rdparty/cpp-btree/btree_map.h"
+#include "3rdparty/cpp-btree/btree_set.h"
+
+#include <algorithm>
+#include <vector>
 
 #include "safeguards.h"
 
 /** The table/list with animated tiles. */
 btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
 
+/**
+ * Number of animation speed buckets.
+ * A tile with speed N is animated on ticks which are a multiple of 2^N, speeds above 32 are never animated.
+ */
+static const uint ANIMATED_TILE_BUCKET_COUNT = 33;
+
+/** The animated tiles (including ones pending deletion) of each speed, so that each tick only visits the tiles which are due. */
+static btree::btree_set<TileIndex> _animated_tile_buckets[ANIMATED_TILE_BUCKET_COUNT];
+
+/** Tiles which were marked as pending deletion, and which should be removed from the table at the end of the next animation tick. */
+static std::vector<TileIndex> _animated_tile_pending_deletions;
+
+static void AddAnimatedTileToBucket(TileIndex tile, uint8 speed)
+{
+	if (speed < ANIMATED_TILE_BUCKET_COUNT) _animated_tile_buckets[speed].insert(tile);
+}
+
+static void RemoveAnimatedTileFromBucket(TileIndex tile, uint8 speed)
+{
+	if (speed < ANIMATED_TILE_BUCKET_COUNT) _animated_tile_buckets[speed].erase(tile);
+}
+
+static void ClearAnimatedTileBuckets()
+{
+	for (auto &bucket : _animated_tile_buckets) {
+		bucket.clear();
+	}
+	_animated_tile_pending_deletions.clear();
+}
+
 /**
  * Removes the given tile from the animated tile table.
  * @param tile the tile to remove
@@ -31,10 +65,26 @@ void DeleteAnimatedTile(TileIndex tile)
 	auto to_remove = _animated_tiles.find(tile);
 	if (to_remove != _animated_tiles.end() && !to_remove->second.pending_deletion) {
 		to_remove->second.pending_deletion = true;
+		_animated_tile_pending_deletions.push_back(tile);
 		MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE);
 	}
 }
 
+/**
+ * Remove the tiles which are still pending deletion from the table and the speed buckets.
+ */
+static void FlushAnimatedTilePendingDeletions()
+{
+	for (TileIndex tile : _animated_tile_pending_deletions) {
+		auto iter = _animated_tiles.find(tile);
+		if (iter != _animated_tiles.end() && iter->second.pending_deletion) {
+			RemoveAnimatedTileFromBucket(tile, iter->second.speed);
+			_animated_tiles.erase(iter);
+		}
+	}
+	_animated_tile_pending_deletions.clear();
+}
+
 static void UpdateAnimatedTileSpeed(TileIndex tile, AnimatedTileInfo &info)
 {
 	extern uint8 GetAnimatedTileSpeed_Town(TileIndex tile);
@@ -73,9 +123,21 @@ static void UpdateAnimatedTileSpeed(TileIndex tile, AnimatedTileInfo &info)
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE);
-	AnimatedTileInfo &info = _animated_tiles[tile];
-	UpdateAnimatedTileSpeed(tile, info);
-	info.pending_deletion = false;
+	auto iter = _animated_tiles.find(tile);
+	if (iter == _animated_tiles.end()) {
+		AnimatedTileInfo &info = _animated_tiles[tile];
+		UpdateAnimatedTileSpeed(tile, info);
+		AddAnimatedTileToBucket(tile, info.speed);
+	} else {
+		AnimatedTileInfo &info = iter->second;
+		const uint8 old_speed = info.speed;
+		UpdateAnimatedTileSpeed(tile, info);
+		if (info.speed != old_speed) {
+			RemoveAnimatedTileFromBucket(tile, old_speed);
+			AddAnimatedTileToBucket(tile, info.speed);
+		}
+		info.pending_deletion = false;
+	}
 }
 
 int GetAnimatedTileSpeed(TileIndex tile)
@@ -102,42 +164,50 @@ void AnimateAnimatedTiles()
 	const uint32 ticks = (uint) _scaled_tick_counter;
 	const uint8 max_speed = (ticks == 0) ? 32 : FindFirstBit(ticks);
 
-	auto iter = _animated_tiles.begin();
-	while (iter != _animated_tiles.end()) {
-		if (iter->second.pending_deletion) {
-			iter = _animated_tiles.erase(iter);
-			continue;
-		}
+	/* Collect the due tiles from the speed buckets in tile order first, as animating a tile may add or remove animated tiles. */
+	static std::vector<TileIndex> due_tiles;
+	due_tiles.clear();
+	for (uint speed = 0; speed <= max_speed; speed++) {
+		const auto &bucket = _animated_tile_buckets[speed];
+		if (bucket.empty()) continue;
+		const size_t merge_offset = due_tiles.size();
+		due_tiles.insert(due_tiles.end(), bucket.begin(), bucket.end());
+		if (merge_offset > 0) std::inplace_merge(due_tiles.begin(), due_tiles.begin() + merge_offset, due_tiles.end());
+	}
+
+	for (const TileIndex curr : due_tiles) {
+		/* The tile may have been removed or changed speed by a tile animated earlier in this tick. */
+		const auto iter = _animated_tiles.find(curr);
+		if (iter == _animated_tiles.end() || iter->second.pending_deletion || iter->second.speed > max_speed) continue;
 
-		if (iter->second.speed <= max_speed) {
-			const TileIndex curr = iter->first;
-			switch (GetTileType(curr)) {
-				case MP_HOUSE:
-					AnimateTile_Town(curr);
-					break;
+		switch (GetTileType(curr)) {
+			case MP_HOUSE:
+				AnimateTile_Town(curr);
+				break;
 
-				case MP_STATION:
-					AnimateTile_Station(curr);
-					break;
+			case MP_STATION:
+				AnimateTile_Station(curr);
+				break;
 
-				case MP_INDUSTRY:
-					AnimateTile_Industry(curr);
-					break;
+			case MP_INDUSTRY:
+				AnimateTile_Industry(curr);
+				break;
 
-				case MP_OBJECT:
-					AnimateTile_Object(curr);
-					break;
+			case MP_OBJECT:
+				AnimateTile_Object(curr);
+				break;
 
-				default:
-					NOT_REACHED();
-			}
+			default:
+				NOT_REACHED();
 		}
-		++iter;
 	}
+
+	FlushAnimatedTilePendingDeletions();
 }
 
 void UpdateAllAnimatedTileSpeeds()
 {
+	ClearAnimatedTileBuckets();
 	auto iter = _animated_tiles.begin();
 	while (iter != _animated_tiles.end()) {
 		if (iter->second.pending_deletion) {
@@ -145,6 +215,25 @@ void UpdateAllAnimatedTileSpeeds()
 			continue;
 		}
 		UpdateAnimatedTileSpeed(iter->first, iter->second);
+		AddAnimatedTileToBucket(iter->first, iter->second.speed);
+		++iter;
+	}
+}
+
+/**
+ * Rebuild the animated tile speed buckets from the animated tile table, using the existing speeds.
+ * This must be called after the table has been modified directly, e.g. when loading.
+ */
+void RebuildAnimatedTileBuckets()
+{
+	ClearAnimatedTileBuckets();
+	auto iter = _animated_tiles.begin();
+	while (iter != _animated_tiles.end()) {
+		if (iter->second.pending_deletion) {
+			iter = _animated_tiles.erase(iter);
+			continue;
+		}
+		AddAnimatedTileToBucket(iter->first, iter->second.speed);
 		++iter;
 	}
 }
@@ -155,4 +244,5 @@ void UpdateAllAnimatedTileSpeeds()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.clear();
+	ClearAnimatedTileBuckets();
 }
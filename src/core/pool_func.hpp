@@ -100,6 +100,26 @@ DEFINE_POOL_METHOD(inline size_t)::FindFirstFree()
 	return NO_FREE_ITEM;
 }
 
+/**
+ * Allocates a block of memory for Tgrowth_step items and adds them all to the
+ * alloc cache. This keeps items of caching pools close together in memory and
+ * avoids a malloc for every single item.
+ * @param size size of item
+ */
+DEFINE_POOL_METHOD(void)::AllocateChunk(size_t size)
+{
+	assert(sizeof(Titem) == size);
+	byte *chunk = MallocT<byte>(size * Tgrowth_step);
+	this->alloc_chunks.push_back(chunk);
+
+	/* Add the items in reverse, so they are handed out in memory order. */
+	for (size_t i = Tgrowth_step; i > 0; i--) {
+		AllocCache *ac = (AllocCache *)(chunk + (i - 1) * size);
+		ac->next = this->alloc_cache;
+		this->alloc_cache = ac;
+	}
+}
+
 /**
  * Makes given index valid
  * @param size size of item
@@ -114,8 +134,10 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 	this->first_unused = std::max(this->first_unused, index + 1);
 	this->items++;
 
+	if (Tcache && this->alloc_cache == nullptr) this->AllocateChunk(size);
+
 	Titem *item;
-	if (Tcache && this->alloc_cache != nullptr) {
+	if (Tcache) {
 		assert(sizeof(Titem) == size);
 		item = (Titem *)this->alloc_cache;
 		this->alloc_cache = this->alloc_cache->next;
@@ -222,11 +244,10 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 	this->cleaning = false;
 
 	if (Tcache) {
-		while (this->alloc_cache != nullptr) {
-			AllocCache *ac = this->alloc_cache;
-			this->alloc_cache = ac->next;
-			free(ac);
-		}
+		/* All items are back in the alloc cache, which only points into the chunks. */
+		this->alloc_cache = nullptr;
+		for (void *chunk : this->alloc_chunks) free(chunk);
+		this->alloc_chunks.clear();
 	}
 }
 
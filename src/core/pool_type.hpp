@@ -73,7 +73,8 @@ private:
  * @tparam Tgrowth_step Size of growths; if the pool is full increase the size by this amount
  * @tparam Tmax_size    Maximum size of the pool
  * @tparam Tpool_type   Type of this pool
- * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory
+ * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory.
+ *                      Items of such pools are allocated in blocks of Tgrowth_step items.
  * @tparam Tzero        Whether to zero the memory
  * @warning when Tcache is enabled *all* instances of this pool's item must be of the same size.
  */
@@ -409,6 +410,11 @@ private:
 	/** Cache of freed pointers */
 	AllocCache *alloc_cache;
 
+	/** Blocks of memory the items of a caching pool are carved from, Tgrowth_step items each */
+	std::vector<void *> alloc_chunks;
+
+	void AllocateChunk(size_t size);
+
 	void *AllocateItem(size_t size, size_t index);
 	void ResizeFor(size_t index);
 	size_t FindFirstFree();
@@ -146,27 +146,45 @@ protected:
 		CompanyMask companies = 0;
 		int unitnumber_max[4] = { -1, -1, -1, -1 };
 
-		for (const Vehicle *v : Vehicle::Iterate()) {
-			if (v->type < 4 && this->show_types[v->type] && v->IsPrimaryVehicle()) {
-				for(const Order *order : v->Orders()) {
-					if ((order->IsType(OT_GOTO_STATION) || order->IsType(OT_GOTO_WAYPOINT) || order->IsType(OT_IMPLICIT))
-							&& order->GetDestination() == this->station) {
-						this->vehicles.push_back(v);
-
-						if (v->name.empty()) {
-							if (v->unitnumber > unitnumber_max[v->type]) unitnumber_max[v->type] = v->unitnumber;
-						} else {
-							SetDParam(0, (uint64)(v->index));
-							int width = (GetStringBoundingBox(STR_DEPARTURES_VEH)).width;
-							if (width > this->veh_width) this->veh_width = width;
-						}
+		auto add_vehicle = [&](const Vehicle *v) {
+			this->vehicles.push_back(v);
 
-						if (v->group_id != INVALID_GROUP && v->group_id != DEFAULT_GROUP) {
-							groups.insert(v->group_id);
-						}
+			if (v->name.empty()) {
+				if (v->unitnumber > unitnumber_max[v->type]) unitnumber_max[v->type] = v->unitnumber;
+			} else {
+				SetDParam(0, (uint64)(v->index));
+				int width = (GetStringBoundingBox(STR_DEPARTURES_VEH)).width;
+				if (width > this->veh_width) this->veh_width = width;
+			}
 
-						SetBit(companies, v->owner);
-						break;
+			if (v->group_id != INVALID_GROUP && v->group_id != DEFAULT_GROUP) {
+				groups.insert(v->group_id);
+			}
+
+			SetBit(companies, v->owner);
+		};
+
+		if (_order_destination_refcount_map_valid) {
+			/* Only visit the order lists which have an order to this station */
+			IterateOrderListsForDestination(this->station, false, [&](OrderListID list_id) {
+				const Vehicle *v = OrderList::Get(list_id)->GetFirstSharedVehicle();
+				if (v == nullptr || v->type >= 4 || !this->show_types[v->type] || !v->IsPrimaryVehicle()) return;
+				for (; v != nullptr; v = v->NextShared()) {
+					add_vehicle(v);
+				}
+			});
+			std::sort(this->vehicles.begin(), this->vehicles.end(), [](const Vehicle *a, const Vehicle *b) {
+				return a->index < b->index;
+			});
+		} else {
+			for (const Vehicle *v : Vehicle::Iterate()) {
+				if (v->type < 4 && this->show_types[v->type] && v->IsPrimaryVehicle()) {
+					for(const Order *order : v->Orders()) {
+						if ((order->IsType(OT_GOTO_STATION) || order->IsType(OT_GOTO_WAYPOINT) || order->IsType(OT_IMPLICIT))
+								&& order->GetDestination() == this->station) {
+							add_vehicle(v);
+							break;
+						}
 					}
 				}
 			}
@@ -10,6 +10,7 @@
 #include "framerate_type.h"
 #include <chrono>
 #include "gfx_func.h"
+#include "gfx_layout.h"
 #include "window_gui.h"
 #include "window_func.h"
 #include "table/sprites.h"
@@ -1077,4 +1078,34 @@ void ConPrintFramerate()
 	if (!printed_anything) {
 		IConsoleWarning("No performance measurements have been taken yet");
 	}
+
+	extern uint GetVehicleTileHashStats(uint &used_buckets, uint &total_vehicles, uint &max_chain);
+	uint used_buckets, total_vehicles, max_chain;
+	uint total_buckets = GetVehicleTileHashStats(used_buckets, total_vehicles, max_chain);
+	if (total_vehicles > 0) {
+		IConsolePrintF(TC_SILVER, "Vehicle tile hash: %u buckets, %u used, average chain length: %.2f, max chain length: %u",
+			total_buckets,
+			used_buckets,
+			(double)total_vehicles / used_buckets,
+			max_chain);
+	}
+
+	extern uint64 GetYapfRailSegmentCacheStats(uint64 &misses);
+	uint64 segment_misses;
+	uint64 segment_hits = GetYapfRailSegmentCacheStats(segment_misses);
+	if (segment_hits + segment_misses > 0) {
+		IConsolePrintF(TC_SILVER, "YAPF rail segment cache: " OTTD_PRINTF64U " hits, " OTTD_PRINTF64U " misses, hit rate: %.1f%%",
+			segment_hits,
+			segment_misses,
+			100.0 * segment_hits / (segment_hits + segment_misses));
+	}
+
+	uint64 line_misses;
+	uint64 line_hits = Layouter::GetLineCacheStats(line_misses);
+	if (line_hits + line_misses > 0) {
+		IConsolePrintF(TC_SILVER, "Text layout line cache: " OTTD_PRINTF64U " hits, " OTTD_PRINTF64U " misses, hit rate: %.1f%%",
+			line_hits,
+			line_misses,
+			100.0 * line_hits / (line_hits + line_misses));
+	}
 }
@@ -15,6 +15,9 @@
 
 #include "table/control_codes.h"
 
+#include <algorithm>
+#include <tuple>
+
 #ifdef WITH_ICU_LX
 #include <unicode/ustring.h>
 #endif /* WITH_ICU_LX */
@@ -32,6 +35,8 @@
 
 /** Cache of ParagraphLayout lines. */
 Layouter::LineCache *Layouter::linecache;
+uint64 Layouter::linecache_access_counter = 0;
+uint64 Layouter::linecache_hits = 0;
 
 /** Cache of Font instances. */
 Layouter::FontColourMap Layouter::fonts[FS_END];
@@ -888,8 +893,13 @@ Layouter::LineCacheItem &Layouter::GetCachedParagraphLayout(const char *str, siz
 		linecache = new LineCache();
 	}
 
+	linecache_access_counter++;
+
 	if (auto match = linecache->find(LineCacheQuery{state, std::string_view{str, len}});
 		match != linecache->end()) {
+		linecache_hits++;
+		match->second.last_access = linecache_access_counter;
+		match->second.uses++;
 		return match->second;
 	}
 
@@ -897,7 +907,10 @@ Layouter::LineCacheItem &Layouter::GetCachedParagraphLayout(const char *str, siz
 	LineCacheKey key;
 	key.state_before = state;
 	key.str.assign(str, len);
-	return (*linecache)[key];
+	LineCacheItem &item = (*linecache)[key];
+	item.last_access = linecache_access_counter;
+	item.uses = 1;
+	return item;
 }
 
 /**
@@ -910,11 +923,52 @@ void Layouter::ResetLineCache()
 
 /**
  * Reduce the size of linecache if necessary to prevent infinite growth.
+ * The least recently used lines are evicted until the cache is down to three
+ * quarters of its maximum size. Lines which have been used more than once
+ * since the previous eviction round are only evicted after those which
+ * haven't, so lines which are laid out over and over again, e.g. by windows
+ * with long lists, survive a burst of one-off lines.
  */
 void Layouter::ReduceLineCache()
 {
-	if (linecache != nullptr) {
-		/* TODO LRU cache would be fancy, but not exactly necessary */
-		if (linecache->size() > 4096) ResetLineCache();
+	if (linecache == nullptr || linecache->size() <= MAX_LINE_CACHE_SIZE) return;
+
+	struct EvictionCandidate {
+		bool frequent;
+		uint64 last_access;
+		LineCache::iterator iter;
+
+		bool operator<(const EvictionCandidate &other) const
+		{
+			return std::tie(this->frequent, this->last_access) < std::tie(other.frequent, other.last_access);
+		}
+	};
+
+	std::vector<EvictionCandidate> candidates;
+	candidates.reserve(linecache->size());
+	for (auto iter = linecache->begin(); iter != linecache->end(); ++iter) {
+		candidates.push_back({ iter->second.uses > 1, iter->second.last_access, iter });
 	}
+
+	size_t evict = linecache->size() - (MAX_LINE_CACHE_SIZE * 3 / 4);
+	std::nth_element(candidates.begin(), candidates.begin() + evict, candidates.end());
+	for (size_t i = 0; i < evict; i++) {
+		linecache->erase(candidates[i].iter);
+	}
+
+	/* Age the use counts, so lines which were only used often in the past can be evicted eventually. */
+	for (auto &it : *linecache) {
+		it.second.uses /= 2;
+	}
+}
+
+/**
+ * Get the hit and miss counts of the linecache.
+ * @param[out] misses Number of lookups which had to lay out the line.
+ * @return Number of lookups which found the line in the cache.
+ */
+uint64 Layouter::GetLineCacheStats(uint64 &misses)
+{
+	misses = linecache_access_counter - linecache_hits;
+	return linecache_hits;
 }
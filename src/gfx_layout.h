@@ -188,13 +188,22 @@ public:
 		FontState state_after;     ///< Font state after the line.
 		ParagraphLayouter *layout; ///< Layout of the line.
 
-		LineCacheItem() : buffer(nullptr), layout(nullptr) {}
+		uint64 last_access;        ///< Value of the access counter when the line was last used.
+		uint uses;                 ///< Number of times the line was used, halved on each eviction round.
+
+		LineCacheItem() : buffer(nullptr), layout(nullptr), last_access(0), uses(0) {}
 		~LineCacheItem() { delete layout; free(buffer); }
 	};
 private:
 	typedef std::map<LineCacheKey, LineCacheItem, LineCacheCompare> LineCache;
 	static LineCache *linecache;
 
+	/** Maximum number of lines in the linecache, before the least recently used ones are evicted. */
+	static const size_t MAX_LINE_CACHE_SIZE = 4096;
+
+	static uint64 linecache_access_counter; ///< Number of linecache lookups, used as clock for the LRU.
+	static uint64 linecache_hits;           ///< Number of linecache lookups which found the line.
+
 	static LineCacheItem &GetCachedParagraphLayout(const char *str, size_t len, const FontState &state);
 
 	typedef SmallMap<TextColour, Font *> FontColourMap;
@@ -210,6 +219,7 @@ public:
 	static void ResetFontCache(FontSize size);
 	static void ResetLineCache();
 	static void ReduceLineCache();
+	static uint64 GetLineCacheStats(uint64 &misses);
 };
 
 #endif /* GFX_LAYOUT_H */
@@ -506,6 +506,7 @@ void GfxLoadSprites()
 	VideoDriver::GetInstance()->ClearSystemSprites();
 	ClearFontCache();
 	GfxInitSpriteMem();
+	ClearGRFSpriteOffsetsCache(_grfconfig);
 	LoadSpriteTables();
 	GfxInitPalettes();
 	GfxDetermineMainColours();
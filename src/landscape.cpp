@@ -10,6 +10,7 @@
 /** @defgroup SnowLineGroup Snowline functions and data structures */
 
 #include "stdafx.h"
+#include INCLUDE_FOR_PREFETCH_NTA
 #include "heightmap.h"
 #include "clear_map.h"
 #include "spritecache.h"
@@ -861,11 +862,29 @@ void RunTileLoop()
 		count--;
 	}
 
+	/* Get the next tile in sequence using a Galois LFSR. */
+	auto next_tile = [feedback](TileIndex t) -> TileIndex {
+		return (t >> 1) ^ (-(int32)(t & 1) & feedback);
+	};
+
+	/* The pseudorandom order means that nearly every tile visited misses the cache,
+	 * so prefetch the map arrays a few tiles ahead of the one being processed. */
+	static const uint PREFETCH_DISTANCE = 8;
+	TileIndex prefetch_tile = tile;
+	for (uint i = 0; i < PREFETCH_DISTANCE; i++) {
+		PREFETCH_NTA(&_m[prefetch_tile]);
+		PREFETCH_NTA(&_me[prefetch_tile]);
+		prefetch_tile = next_tile(prefetch_tile);
+	}
+
 	while (count--) {
+		PREFETCH_NTA(&_m[prefetch_tile]);
+		PREFETCH_NTA(&_me[prefetch_tile]);
+		prefetch_tile = next_tile(prefetch_tile);
+
 		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
 
-		/* Get the next tile in sequence using a Galois LFSR. */
-		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+		tile = next_tile(tile);
 	}
 
 	_cur_tileloop_tile = tile;
@@ -12,14 +12,15 @@
 
 #include "../core/pool_type.hpp"
 #include "../core/smallmap_type.hpp"
-#include "../core/smallmatrix_type.hpp"
 #include "../core/bitmath_func.hpp"
 #include "../station_base.h"
 #include "../cargotype.h"
 #include "../date_func.h"
 #include "../saveload/saveload_common.h"
 #include "linkgraph_type.h"
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 class LinkGraph;
 
@@ -47,10 +48,25 @@ namespace upstream_sl {
 class LinkGraph : public LinkGraphPool::PoolItem<&_link_graph_pool> {
 public:
 
+	/**
+	 * An edge in the link graph. Corresponds to a link between two stations.
+	 */
+	struct BaseEdge {
+		uint capacity;                 ///< Capacity of the link.
+		uint usage;                    ///< Usage of the link.
+		Date last_unrestricted_update; ///< When the unrestricted part of the link was last updated.
+		Date last_restricted_update;   ///< When the restricted part of the link was last updated.
+		NodeID dest_node;              ///< Destination of the edge.
+		void Init(NodeID dest_node = INVALID_NODE);
+	};
+
 	/**
 	 * Node of the link graph. contains all relevant information from the associated
 	 * station. It's copied so that the link graph job can work on its own data set
 	 * in a separate thread.
+	 * The outgoing edges are kept in an array sorted by destination node. Most
+	 * stations only have a handful of links, so this is a lot smaller than a full
+	 * matrix and cheap to copy when spawning a job.
 	 */
 	struct BaseNode {
 		uint supply;             ///< Supply at the station.
@@ -58,24 +74,59 @@ public:
 		StationID station;       ///< Station ID.
 		TileIndex xy;            ///< Location of the station referred to by the node.
 		Date last_update;        ///< When the supply was last updated.
+		std::vector<BaseEdge> edges; ///< Outgoing edges, sorted by destination node.
 		void Init(TileIndex xy = INVALID_TILE, StationID st = INVALID_STATION, uint demand = 0);
-	};
 
-	/**
-	 * An edge in the link graph. Corresponds to a link between two stations or at
-	 * least the distance between them. Edges from one node to itself contain the
-	 * ID of the opposite Node of the first active edge (i.e. not just distance) in
-	 * the column as next_edge.
-	 */
-	struct BaseEdge {
-		uint capacity;                 ///< Capacity of the link.
-		uint usage;                    ///< Usage of the link.
-		Date last_unrestricted_update; ///< When the unrestricted part of the link was last updated.
-		Date last_restricted_update;   ///< When the restricted part of the link was last updated.
-		NodeID next_edge;              ///< Destination of next valid edge starting at the same source node.
-		void Init();
+		/**
+		 * Find the first outgoing edge whose destination is not lower than the given node.
+		 * @param to Destination node to search for.
+		 * @return Iterator to the edge, or edges.end() if there is none.
+		 */
+		std::vector<BaseEdge>::iterator EdgeLowerBound(NodeID to)
+		{
+			return std::lower_bound(this->edges.begin(), this->edges.end(), to, [](const BaseEdge &edge, NodeID to) {
+				return edge.dest_node < to;
+			});
+		}
+
+		/**
+		 * Find the first outgoing edge whose destination is not lower than the given node.
+		 * @param to Destination node to search for.
+		 * @return Iterator to the edge, or edges.end() if there is none.
+		 */
+		std::vector<BaseEdge>::const_iterator EdgeLowerBound(NodeID to) const
+		{
+			return std::lower_bound(this->edges.begin(), this->edges.end(), to, [](const BaseEdge &edge, NodeID to) {
+				return edge.dest_node < to;
+			});
+		}
+
+		/**
+		 * Get the outgoing edge to the given node.
+		 * @param to Destination node.
+		 * @return The edge or nullptr if there is no such edge.
+		 */
+		BaseEdge *GetEdge(NodeID to)
+		{
+			auto iter = this->EdgeLowerBound(to);
+			return (iter != this->edges.end() && iter->dest_node == to) ? &(*iter) : nullptr;
+		}
+
+		/**
+		 * Get the outgoing edge to the given node.
+		 * @param to Destination node.
+		 * @return The edge or nullptr if there is no such edge.
+		 */
+		const BaseEdge *GetEdge(NodeID to) const
+		{
+			auto iter = this->EdgeLowerBound(to);
+			return (iter != this->edges.end() && iter->dest_node == to) ? &(*iter) : nullptr;
+		}
 	};
 
+	/** Empty edge returned when asking for an edge between unconnected nodes. */
+	static const BaseEdge EMPTY_EDGE;
+
 	/**
 	 * Wrapper for an edge (const or not) allowing retrieval, but no modification.
 	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
@@ -126,14 +177,12 @@ public:
 
 	/**
 	 * Wrapper for a node (const or not) allowing retrieval, but no modification.
-	 * @tparam Tedge Actual node class, may be "const BaseNode" or just "BaseNode".
-	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
+	 * @tparam Tnode Actual node class, may be "const BaseNode" or just "BaseNode".
 	 */
-	template<typename Tnode, typename Tedge>
+	template<typename Tnode>
 	class NodeWrapper {
 	protected:
 		Tnode &node;  ///< Node being wrapped.
-		Tedge *edges; ///< Outgoing edges for wrapped node.
 		NodeID index; ///< ID of wrapped node.
 
 	public:
@@ -141,11 +190,9 @@ public:
 		/**
 		 * Wrap a node.
 		 * @param node Node to be wrapped.
-		 * @param edges Outgoing edges for node to be wrapped.
 		 * @param index ID of node to be wrapped.
 		 */
-		NodeWrapper(Tnode &node, Tedge *edges, NodeID index) : node(node),
-			edges(edges), index(index) {}
+		NodeWrapper(Tnode &node, NodeID index) : node(node), index(index) {}
 
 		/**
 		 * Get supply of wrapped node.
@@ -179,50 +226,49 @@ public:
 	};
 
 	/**
-	 * Base class for iterating across outgoing edges of a node. Only the real
-	 * edges (those with capacity) are iterated. The ones with only distance
-	 * information are skipped.
+	 * A "fake" pointer to enable operator-> on temporaries. As the objects
+	 * returned from operator* of the edge iterators aren't references but real
+	 * objects, we have to return something that implements operator->, but isn't
+	 * a pointer from operator->. A fake pointer.
+	 * @tparam Tedge_wrapper Edge wrapper class being "pointed" to.
+	 */
+	template <class Tedge_wrapper>
+	class FakeEdgePointer : public std::pair<NodeID, Tedge_wrapper> {
+	public:
+
+		/**
+		 * Construct a fake pointer from a pair of NodeID and edge.
+		 * @param pair Pair to be "pointed" to (in fact shallow-copied).
+		 */
+		FakeEdgePointer(const std::pair<NodeID, Tedge_wrapper> &pair) : std::pair<NodeID, Tedge_wrapper>(pair) {}
+
+		/**
+		 * Retrieve the pair by operator->.
+		 * @return Pair being "pointed" to.
+		 */
+		std::pair<NodeID, Tedge_wrapper> *operator->() { return this; }
+	};
+
+	/**
+	 * Base class for iterating across the outgoing edges of a node, in order of
+	 * their destination node. The iterator points directly into the node's edge
+	 * array, so it is invalidated by adding or removing edges of that node.
 	 * @tparam Tedge Actual edge class. May be "BaseEdge" or "const BaseEdge".
 	 * @tparam Titer Actual iterator class.
 	 */
 	template <class Tedge, class Tedge_wrapper, class Titer>
 	class BaseEdgeIterator {
 	protected:
-		Tedge *base;    ///< Array of edges being iterated.
-		NodeID current; ///< Current offset in edges array.
+		Tedge *current; ///< Current edge in the node's edge array.
 
-		/**
-		 * A "fake" pointer to enable operator-> on temporaries. As the objects
-		 * returned from operator* aren't references but real objects, we have
-		 * to return something that implements operator->, but isn't a pointer
-		 * from operator->. A fake pointer.
-		 */
-		class FakePointer : public std::pair<NodeID, Tedge_wrapper> {
-		public:
-
-			/**
-			 * Construct a fake pointer from a pair of NodeID and edge.
-			 * @param pair Pair to be "pointed" to (in fact shallow-copied).
-			 */
-			FakePointer(const std::pair<NodeID, Tedge_wrapper> &pair) : std::pair<NodeID, Tedge_wrapper>(pair) {}
-
-			/**
-			 * Retrieve the pair by operator->.
-			 * @return Pair being "pointed" to.
-			 */
-			std::pair<NodeID, Tedge_wrapper> *operator->() { return this; }
-		};
+		typedef FakeEdgePointer<Tedge_wrapper> FakePointer;
 
 	public:
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param current ID of current node (to locate the first edge).
+		 * @param current Edge to start iterating at.
 		 */
-		BaseEdgeIterator (Tedge *base, NodeID current) :
-			base(base),
-			current(current == INVALID_NODE ? current : base[current].next_edge)
-		{}
+		BaseEdgeIterator (Tedge *current) : current(current) {}
 
 		/**
 		 * Prefix-increment.
@@ -230,7 +276,7 @@ public:
 		 */
 		Titer &operator++()
 		{
-			this->current = this->base[this->current].next_edge;
+			++this->current;
 			return static_cast<Titer &>(*this);
 		}
 
@@ -241,7 +287,7 @@ public:
 		Titer operator++(int)
 		{
 			Titer ret(static_cast<Titer &>(*this));
-			this->current = this->base[this->current].next_edge;
+			++this->current;
 			return ret;
 		}
 
@@ -250,12 +296,12 @@ public:
 		 * child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If the iterators have the same edge array and current node.
+		 * @return If the iterators point to the same edge.
 		 */
 		template<class Tother>
 		bool operator==(const Tother &other)
 		{
-			return this->base == other.base && this->current == other.current;
+			return this->current == other.current;
 		}
 
 		/**
@@ -263,12 +309,12 @@ public:
 		 * may be of a child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If either the edge arrays or the current nodes differ.
+		 * @return If the iterators point to different edges.
 		 */
 		template<class Tother>
 		bool operator!=(const Tother &other)
 		{
-			return this->base != other.base || this->current != other.current;
+			return this->current != other.current;
 		}
 
 		/**
@@ -277,7 +323,7 @@ public:
 		 */
 		std::pair<NodeID, Tedge_wrapper> operator*() const
 		{
-			return std::pair<NodeID, Tedge_wrapper>(this->current, Tedge_wrapper(this->base[this->current]));
+			return std::pair<NodeID, Tedge_wrapper>(this->current->dest_node, Tedge_wrapper(*this->current));
 		}
 
 		/**
@@ -317,33 +363,112 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param current Edge to start iterating at.
 		 */
-		ConstEdgeIterator(const BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator>(edges, current) {}
+		ConstEdgeIterator(const BaseEdge *current) :
+			BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator>(current) {}
 	};
 
 	/**
-	 * An iterator for non-const edges. Cannot be typedef'ed because of
-	 * template-reference to EdgeIterator itself.
+	 * An iterator for non-const edges. Unlike the other edge iterators this one
+	 * only remembers the destination of the current edge and looks it up again
+	 * when needed. Thus edges of the node may be added or removed while iterating,
+	 * as long as the current edge isn't removed before advancing.
 	 */
-	class EdgeIterator : public BaseEdgeIterator<BaseEdge, Edge, EdgeIterator> {
+	class EdgeIterator {
+	protected:
+		BaseNode *node; ///< Node whose edges are iterated.
+		NodeID current; ///< Destination of current edge.
+
+		typedef FakeEdgePointer<Edge> FakePointer;
+
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param node Node whose edges are iterated.
+		 * @param current Destination of the edge to start iterating at.
+		 */
+		EdgeIterator(BaseNode *node, NodeID current) : node(node), current(current) {}
+
+		/**
+		 * Prefix-increment.
+		 * @return This.
+		 */
+		EdgeIterator &operator++()
+		{
+			auto iter = this->node->EdgeLowerBound(this->current + 1);
+			this->current = (iter != this->node->edges.end()) ? iter->dest_node : INVALID_NODE;
+			return *this;
+		}
+
+		/**
+		 * Postfix-increment.
+		 * @return Version of this before increment.
+		 */
+		EdgeIterator operator++(int)
+		{
+			EdgeIterator ret(*this);
+			++(*this);
+			return ret;
+		}
+
+		/**
+		 * Compare with some other edge iterator.
+		 * @param other Instance of other iterator.
+		 * @return If the iterators have the same node and current destination.
+		 */
+		bool operator==(const EdgeIterator &other) const
+		{
+			return this->node == other.node && this->current == other.current;
+		}
+
+		/**
+		 * Compare for inequality with some other edge iterator.
+		 * @param other Instance of other iterator.
+		 * @return If either the nodes or the current destinations differ.
 		 */
-		EdgeIterator(BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<BaseEdge, Edge, EdgeIterator>(edges, current) {}
+		bool operator!=(const EdgeIterator &other) const
+		{
+			return this->node != other.node || this->current != other.current;
+		}
+
+		/**
+		 * Dereference with operator*.
+		 * @return Pair of current target NodeID and edge object.
+		 */
+		std::pair<NodeID, Edge> operator*() const
+		{
+			BaseEdge *edge = this->node->GetEdge(this->current);
+			assert(edge != nullptr);
+			return std::pair<NodeID, Edge>(this->current, Edge(*edge));
+		}
+
+		/**
+		 * Dereference with operator->.
+		 * @return Fake pointer to Pair of current target NodeID and edge object.
+		 */
+		FakePointer operator->() const {
+			return FakePointer(this->operator*());
+		}
 	};
 
 	/**
 	 * Constant node class. Only retrieval operations are allowed on both the
 	 * node itself and its edges.
 	 */
-	class ConstNode : public NodeWrapper<const BaseNode, const BaseEdge> {
+	class ConstNode : public NodeWrapper<const BaseNode> {
+	protected:
+		/**
+		 * Get the outgoing edge to the given node.
+		 * @param to ID of end node of edge.
+		 * @return The edge, or an empty edge if the nodes aren't connected.
+		 */
+		const BaseEdge &GetEdge(NodeID to) const
+		{
+			const BaseEdge *edge = this->node.GetEdge(to);
+			return edge != nullptr ? *edge : EMPTY_EDGE;
+		}
+
 	public:
 		/**
 		 * Constructor.
@@ -351,7 +476,7 @@ public:
 		 * @param node ID of the node.
 		 */
 		ConstNode(const LinkGraph *lg, NodeID node) :
-			NodeWrapper<const BaseNode, const BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<const BaseNode>(lg->nodes[node], node)
 		{}
 
 		/**
@@ -360,25 +485,25 @@ public:
 		 * @param to ID of end node of edge.
 		 * @return Constant edge wrapper.
 		 */
-		ConstEdge operator[](NodeID to) const { return ConstEdge(this->edges[to]); }
+		ConstEdge operator[](NodeID to) const { return ConstEdge(this->GetEdge(to)); }
 
 		/**
 		 * Get an iterator pointing to the start of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->edges, this->index); }
+		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->node.edges.data()); }
 
 		/**
 		 * Get an iterator pointing beyond the end of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator End() const { return ConstEdgeIterator(this->edges, INVALID_NODE); }
+		ConstEdgeIterator End() const { return ConstEdgeIterator(this->node.edges.data() + this->node.edges.size()); }
 	};
 
 	/**
 	 * Updatable node class. The node itself as well as its edges can be modified.
 	 */
-	class Node : public NodeWrapper<BaseNode, BaseEdge> {
+	class Node : public NodeWrapper<BaseNode> {
 	public:
 		/**
 		 * Constructor.
@@ -386,28 +511,22 @@ public:
 		 * @param node ID of the node.
 		 */
 		Node(LinkGraph *lg, NodeID node) :
-			NodeWrapper<BaseNode, BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<BaseNode>(lg->nodes[node], node)
 		{}
 
-		/**
-		 * Get an Edge. This is not a reference as the wrapper objects are not
-		 * actually persistent.
-		 * @param to ID of end node of edge.
-		 * @return Edge wrapper.
-		 */
-		Edge operator[](NodeID to) { return Edge(this->edges[to]); }
+		Edge operator[](NodeID to);
 
 		/**
 		 * Get an iterator pointing to the start of the edges array.
 		 * @return Edge iterator.
 		 */
-		EdgeIterator Begin() { return EdgeIterator(this->edges, this->index); }
+		EdgeIterator Begin() { return EdgeIterator(&this->node, this->node.edges.empty() ? INVALID_NODE : this->node.edges.front().dest_node); }
 
 		/**
 		 * Get an iterator pointing beyond the end of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		EdgeIterator End() { return EdgeIterator(this->edges, INVALID_NODE); }
+		EdgeIterator End() { return EdgeIterator(&this->node, INVALID_NODE); }
 
 		/**
 		 * Update the node's supply and set last_update to the current date.
@@ -443,7 +562,6 @@ public:
 	};
 
 	typedef std::vector<BaseNode> NodeVector;
-	typedef SmallMatrix<BaseEdge> EdgeMatrix;
 
 	/** Minimum effective distance for timeout calculation. */
 	static const uint MIN_TIMEOUT_DISTANCE = 32;
@@ -553,8 +671,7 @@ protected:
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
-	NodeVector nodes;      ///< Nodes in the component.
-	EdgeMatrix edges;      ///< Edges in the component.
+	NodeVector nodes;      ///< Nodes in the component, including their outgoing edges.
 };
 
 #endif /* LINKGRAPH_H */
@@ -12,6 +12,7 @@
 
 #include "../thread.h"
 #include "../core/dyn_arena_alloc.hpp"
+#include "../core/smallmatrix_type.hpp"
 #include "linkgraph.h"
 #include <vector>
 #include <memory>
@@ -160,12 +161,11 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param base_anno Array of annotations to be iterated.
-		 * @param current Start offset of iteration.
+		 * @param current Edge to start iterating at.
+		 * @param base_anno Array of annotations to be (indirectly) iterated.
 		 */
-		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, NodeID current) :
-				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(base, current),
+		EdgeIterator(const LinkGraph::BaseEdge *current, EdgeAnnotation *base_anno) :
+				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(current),
 				base_anno(base_anno) {}
 
 		/**
@@ -175,7 +175,8 @@ public:
 		 */
 		std::pair<NodeID, Edge> operator*() const
 		{
-			return std::pair<NodeID, Edge>(this->current, Edge(this->base[this->current], this->base_anno[this->current]));
+			NodeID to = this->current->dest_node;
+			return std::pair<NodeID, Edge>(to, Edge(*this->current, this->base_anno[to]));
 		}
 
 		/**
@@ -214,21 +215,21 @@ public:
 		 * @param to Remote end of the edge.
 		 * @return Edge between this node and "to".
 		 */
-		Edge operator[](NodeID to) const { return Edge(this->edges[to], this->edge_annos[to]); }
+		Edge operator[](NodeID to) const { return Edge(this->GetEdge(to), this->edge_annos[to]); }
 
 		/**
 		 * Iterator for the "begin" of the edge array. Only edges with capacity
 		 * are iterated. The others are skipped.
 		 * @return Iterator pointing to the first edge.
 		 */
-		EdgeIterator Begin() const { return EdgeIterator(this->edges, this->edge_annos, index); }
+		EdgeIterator Begin() const { return EdgeIterator(this->node.edges.data(), this->edge_annos); }
 
 		/**
 		 * Iterator for the "end" of the edge array. Only edges with capacity
 		 * are iterated. The others are skipped.
 		 * @return Iterator pointing beyond the last edge.
 		 */
-		EdgeIterator End() const { return EdgeIterator(this->edges, this->edge_annos, INVALID_NODE); }
+		EdgeIterator End() const { return EdgeIterator(this->node.edges.data() + this->node.edges.size(), this->edge_annos); }
 
 		/**
 		 * Get amount of supply that hasn't been delivered, yet.
@@ -274,8 +274,14 @@ void LinkGraphJobGroup::JoinThread()
 	}
 }
 
+/**
+ * Maximum summed cost estimate of the jobs run together in one thread.
+ * Jobs which alone exceed this always get a thread of their own.
+ */
+uint _linkgraph_job_thread_budget = 200000;
+
 /* static */ void LinkGraphJobGroup::ExecuteJobSet(std::vector<JobInfo> jobs) {
-	const uint thread_budget = 200000;
+	const uint thread_budget = _linkgraph_job_thread_budget;
 
 	std::sort(jobs.begin(), jobs.end(), [](const JobInfo &a, const JobInfo &b) {
 		return std::make_pair(a.job->JoinDateTicks(), a.cost_estimate) < std::make_pair(b.job->JoinDateTicks(), b.cost_estimate);
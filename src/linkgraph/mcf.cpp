@@ -106,8 +106,8 @@ public:
 };
 
 /**
- * Iterator class for getting the edges in the order of their next_edge
- * members.
+ * Iterator class for getting the edges in the order of their destination
+ * nodes.
  */
 class GraphEdgeIterator {
 private:
@@ -122,7 +122,7 @@ public:
 	 * @param job Job to iterate on.
 	 */
 	GraphEdgeIterator(LinkGraphJob &job) : job(job),
-		i(nullptr, nullptr, INVALID_NODE), end(nullptr, nullptr, INVALID_NODE)
+		i(nullptr, nullptr), end(nullptr, nullptr)
 	{}
 
 	/**
@@ -18,6 +18,17 @@
 #include <array>
 #include <deque>
 
+#if defined(UNIX) && !defined(__APPLE__) && !defined(__OpenBSD__)
+/* The backing file of the extended tiles needs posix_fallocate, which these lack. */
+#	define WITH_MAP_EXTENDED_STORAGE_FILE
+#endif
+
+#if defined(WITH_MAP_EXTENDED_STORAGE_FILE)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
 #include "safeguards.h"
 
 #if defined(_MSC_VER)
@@ -35,6 +46,61 @@ uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 Tile *_m = nullptr;          ///< Tiles of the map
 TileExtended *_me = nullptr; ///< Extended Tiles of the map
 
+std::string _map_extended_storage_dir; ///< If not empty, directory in which the backing storage file of the extended tiles (#_me) is created
+static size_t _me_mapped_size = 0;      ///< Size of the file mapping #_me points to, or 0 if #_me was allocated on the heap
+
+/**
+ * Allocate the extended tiles (#_me) of the map.
+ * The extended tiles are accessed much less often than #_m, so if a backing file is configured
+ * they are put in a shared mapping of a new temporary file in the configured directory. The operating
+ * system can then write them back and drop them from memory, instead of them having to stay resident
+ * (or go to swap).
+ * @param size The number of tiles on the map.
+ */
+static void AllocateMapExtended(uint size)
+{
+#if defined(WITH_MAP_EXTENDED_STORAGE_FILE)
+	if (!_map_extended_storage_dir.empty()) {
+		const size_t length = size * sizeof(TileExtended);
+		std::string path = _map_extended_storage_dir;
+		if (path.back() != PATHSEPCHAR) path += PATHSEPCHAR;
+		path += "openttd_map_XXXXXX";
+		/* Always create a new file, so no existing file is overwritten and multiple instances can share the directory. */
+		int fd = mkstemp(path.data());
+		if (fd >= 0) {
+			void *ptr = MAP_FAILED;
+			/* Reserve the space of the whole file, a sparse file could make writing to a page fail with SIGBUS when the disk is full. */
+			if (posix_fallocate(fd, 0, length) == 0) ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			/* The mapping keeps the file alive, no need to leave it around. */
+			close(fd);
+			unlink(path.c_str());
+			if (ptr != MAP_FAILED) {
+				_me = (TileExtended *)ptr;
+				_me_mapped_size = length;
+				return;
+			}
+		}
+		DEBUG(map, 0, "Could not map extended tiles to a file in '%s', using memory instead", _map_extended_storage_dir.c_str());
+	}
+#endif
+	_me = CallocT<TileExtended>(size);
+}
+
+/** Free the extended tiles (#_me) of the map. */
+static void FreeMapExtended()
+{
+#if defined(WITH_MAP_EXTENDED_STORAGE_FILE)
+	if (_me_mapped_size != 0) {
+		munmap(_me, _me_mapped_size);
+		_me = nullptr;
+		_me_mapped_size = 0;
+		return;
+	}
+#endif
+	free(_me);
+	_me = nullptr;
+}
+
 /**
  * Validates whether a map with the given dimension is valid
  * @param size_x the width of the map along the NE/SW edge
@@ -77,10 +143,10 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_tile_mask = _map_size - 1;
 
 	free(_m);
-	free(_me);
+	FreeMapExtended();
 
 	_m = CallocT<Tile>(_map_size);
-	_me = CallocT<TileExtended>(_map_size);
+	AllocateMapExtended(_map_size);
 }
 
 
@@ -115,6 +115,18 @@ typedef unsigned long in_addr_t;
 #	include <sys/time.h>
 #	include <netdb.h>
 
+#	if !defined(__EMSCRIPTEN__)
+/* Send several queued packets with a single gathered write. */
+#		include <sys/uio.h>
+#		define HAVE_WRITEV
+#	endif
+
+#	if defined(__linux__) && !defined(__EMSCRIPTEN__)
+/* Use epoll instead of select for the server's listening and accepted sockets. */
+#		include <sys/epoll.h>
+#		define HAVE_EPOLL
+#	endif
+
 #   if defined(__EMSCRIPTEN__)
 /* Emscripten doesn't support AI_ADDRCONFIG and errors out on it. */
 #		undef AI_ADDRCONFIG
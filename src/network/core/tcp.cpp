@@ -38,6 +38,7 @@ NetworkTCPSocketHandler::~NetworkTCPSocketHandler()
 void NetworkTCPSocketHandler::EmptyPacketQueue()
 {
 	this->packet_queue.clear();
+	this->packet_queue_front_sent = 0;
 	this->packet_recv.reset();
 }
 
@@ -80,7 +81,19 @@ void NetworkTCPSocketHandler::SendPacket(std::unique_ptr<Packet> packet)
 
 	packet->PrepareToSend();
 
-	this->packet_queue.push_back(std::move(packet));
+	this->packet_queue.emplace_back(std::move(packet));
+}
+
+/**
+ * This function puts a packet which may also be queued on other sockets in the send-queue.
+ * The packet is not copied, so it must not be modified after this.
+ * @param packet the packet to send, PrepareToSend must already have been called on it
+ */
+void NetworkTCPSocketHandler::SendSharedPacket(std::shared_ptr<const Packet> packet)
+{
+	assert(packet != nullptr);
+
+	this->packet_queue.emplace_back(std::move(packet));
 }
 
 /**
@@ -97,21 +110,20 @@ void NetworkTCPSocketHandler::SendPrependPacket(std::unique_ptr<Packet> packet,
 
 	if (queue_after_packet_type >= 0) {
 		for (auto iter = this->packet_queue.begin(); iter != this->packet_queue.end(); ++iter) {
-			if ((*iter)->GetPacketType() == queue_after_packet_type) {
+			if (iter->Get().GetPacketType() == queue_after_packet_type) {
 				++iter;
-				this->packet_queue.insert(iter, std::move(packet));
+				this->packet_queue.emplace(iter, std::move(packet));
 				return;
 			}
 		}
 	}
 
-	/* The very first packet in the queue may be partially written out, so cannot be replaced.
-	 * If the queue is non-empty, swap packet with the first packet in the queue.
-	 * The insert the packet (either the incoming packet or the previous first packet) at the front. */
+	/* The very first packet in the queue may be partially written out, so must stay at the front. */
 	if (!this->packet_queue.empty()) {
-		packet.swap(this->packet_queue.front());
+		this->packet_queue.emplace(this->packet_queue.begin() + 1, std::move(packet));
+	} else {
+		this->packet_queue.emplace_front(std::move(packet));
 	}
-	this->packet_queue.push_front(std::move(packet));
 }
 
 /**
@@ -120,6 +132,7 @@ void NetworkTCPSocketHandler::SendPrependPacket(std::unique_ptr<Packet> packet,
  *   2) the OS reports back that it can not send any more
  *      data right now (full network-buffer, it happens ;))
  *   3) sending took too long
+ * Where available, several queued packets are sent with a single gathered write.
  * @param closing_down Whether we are closing down the connection.
  * @return \c true if a (part of a) packet could be sent and
  *         the connection is not closed yet.
@@ -133,8 +146,26 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 	if (!this->IsConnected()) return SPS_CLOSED;
 
 	while (!this->packet_queue.empty()) {
-		Packet *p = this->packet_queue.front().get();
-		res = p->TransferOut<int>(send, this->sock, 0);
+		size_t to_send = 0;
+#ifdef HAVE_WRITEV
+		static const uint MAX_IOV = 64;
+		struct iovec iov[MAX_IOV];
+		uint iov_count = 0;
+		size_t offset = this->packet_queue_front_sent;
+		for (const QueuedPacket &qp : this->packet_queue) {
+			const Packet &p = qp.Get();
+			iov[iov_count].iov_base = const_cast<byte *>(p.GetBufferData() + offset);
+			iov[iov_count].iov_len = p.Size() - offset;
+			to_send += iov[iov_count].iov_len;
+			offset = 0;
+			if (++iov_count == MAX_IOV) break;
+		}
+		res = writev(this->sock, iov, iov_count);
+#else
+		const Packet &p = this->packet_queue.front().Get();
+		to_send = p.Size() - this->packet_queue_front_sent;
+		res = send(this->sock, reinterpret_cast<const char *>(p.GetBufferData() + this->packet_queue_front_sent), static_cast<int>(to_send), 0);
+#endif
 		if (res == -1) {
 			NetworkError err = NetworkError::GetLast();
 			if (!err.WouldBlock()) {
@@ -145,6 +176,7 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+			this->writable = false;
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -153,12 +185,26 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
-		/* Is this packet sent? */
-		if (p->RemainingBytesToTransfer() == 0) {
-			/* Go to the next packet */
-			if (_debug_net_level >= 5) this->LogSentPacket(*p);
-			this->packet_queue.pop_front();
-		} else {
+		/* Advance through the packets which were (partly) sent */
+		size_t sent = static_cast<size_t>(res);
+		while (sent > 0) {
+			const Packet &p = this->packet_queue.front().Get();
+			size_t amount = std::min(sent, p.Size() - this->packet_queue_front_sent);
+			this->packet_queue_front_sent += amount;
+			sent -= amount;
+
+			/* Is this packet sent? */
+			if (this->packet_queue_front_sent == p.Size()) {
+				/* Go to the next packet */
+				if (_debug_net_level >= 5) this->LogSentPacket(p);
+				this->packet_queue.pop_front();
+				this->packet_queue_front_sent = 0;
+			}
+		}
+
+		if (static_cast<size_t>(res) < to_send) {
+			/* The OS buffer is full, wait until it can accept more */
+			this->writable = false;
 			return SPS_PARTLY_SENT;
 		}
 	}
@@ -36,13 +36,29 @@ enum SendPacketsState {
 /** Base socket handler for all TCP sockets */
 class NetworkTCPSocketHandler : public NetworkSocketHandler {
 private:
-	std::deque<std::unique_ptr<Packet>> packet_queue; ///< Packets that are awaiting delivery
-	std::unique_ptr<Packet> packet_recv;              ///< Partially received packet
+	/** A packet awaiting delivery, either owned by this socket or an immutable packet shared with other sockets. */
+	struct QueuedPacket {
+		std::unique_ptr<Packet> owned;         ///< Packet owned by this socket.
+		std::shared_ptr<const Packet> shared;  ///< Packet shared with other sockets.
+
+		QueuedPacket(std::unique_ptr<Packet> packet) : owned(std::move(packet)) {}
+		QueuedPacket(std::shared_ptr<const Packet> packet) : shared(std::move(packet)) {}
+
+		const Packet &Get() const { return this->owned != nullptr ? *this->owned : *this->shared; }
+	};
+
+	std::deque<QueuedPacket> packet_queue; ///< Packets that are awaiting delivery
+	size_t packet_queue_front_sent = 0;    ///< Number of bytes of the first packet in the queue which have already been sent
+	std::unique_ptr<Packet> packet_recv;   ///< Partially received packet
 
 	void EmptyPacketQueue();
 public:
 	SOCKET sock;              ///< The socket currently connected to
 	bool writable;            ///< Can we write to this socket?
+#ifdef HAVE_EPOLL
+	bool epoll_registered = false; ///< Whether the socket is registered with the listen handler's epoll instance.
+	bool epoll_want_write = false; ///< Whether the socket is waiting for an epoll write notification.
+#endif
 
 	/**
 	 * Whether this socket is currently bound to a socket.
@@ -54,6 +70,7 @@ public:
 	void CloseSocket();
 
 	void SendPacket(std::unique_ptr<Packet> packet);
+	void SendSharedPacket(std::shared_ptr<const Packet> packet);
 	void SendPrependPacket(std::unique_ptr<Packet> packet, int queue_after_packet_type);
 
 	void SendPacket(Packet *packet)
@@ -29,6 +29,83 @@ class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
 
+#ifdef HAVE_EPOLL
+	/** The epoll instance for the listening and accepted sockets, or -1 when select is used. */
+	static int epoll_fd;
+
+	/** Tag for the epoll data of listening sockets, the data of accepted sockets is their pool index and socket. */
+	static const uint64 EPOLL_LISTENER_TAG = (uint64)1 << 63;
+
+	static void EpollControl(int op, SOCKET s, uint32 events, uint64 data)
+	{
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = events;
+		ev.data.u64 = data;
+		if (epoll_ctl(epoll_fd, op, s, &ev) < 0) {
+			DEBUG(net, 0, "[%s] epoll_ctl failed: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+		}
+	}
+
+	static uint64 EpollSocketData(const Tsocket *cs)
+	{
+		return (((uint64)cs->index) << 32) | (uint32)cs->sock;
+	}
+
+	/**
+	 * Handle the receiving of packets using epoll.
+	 * Sockets are only registered once, and only the sockets with pending events are visited.
+	 * Sockets stay writable until a send could not complete, after which a write notification is requested.
+	 * @return true if everything went okay.
+	 */
+	static bool ReceiveEpoll()
+	{
+		/* Register new connections and request write notifications for connections with a full send buffer. */
+		for (Tsocket *cs : Tsocket::Iterate()) {
+			if (!cs->IsConnected()) continue;
+			if (!cs->epoll_registered) {
+				EpollControl(EPOLL_CTL_ADD, cs->sock, EPOLLIN, EpollSocketData(cs));
+				cs->epoll_registered = true;
+				cs->epoll_want_write = false;
+				cs->writable = true;
+			} else if (!cs->writable && !cs->epoll_want_write) {
+				EpollControl(EPOLL_CTL_MOD, cs->sock, EPOLLIN | EPOLLOUT, EpollSocketData(cs));
+				cs->epoll_want_write = true;
+			}
+		}
+
+		struct epoll_event events[256];
+		int count = epoll_wait(epoll_fd, events, lengthof(events), 0); // don't block at all.
+		if (count < 0) return errno == EINTR && _networking;
+
+		/* accept clients.. */
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.u64 & EPOLL_LISTENER_TAG) AcceptClient((SOCKET)GB(events[i].data.u64, 0, 32));
+		}
+
+		/* read stuff from clients */
+		for (int i = 0; i < count; i++) {
+			const uint64 data = events[i].data.u64;
+			if (data & EPOLL_LISTENER_TAG) continue;
+
+			Tsocket *cs = Tsocket::GetIfValid(GB(data, 32, 31));
+			if (cs == nullptr || !cs->IsConnected() || (uint32)cs->sock != GB(data, 0, 32)) continue;
+
+			if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+				cs->writable = true;
+				if (cs->epoll_want_write) {
+					EpollControl(EPOLL_CTL_MOD, cs->sock, EPOLLIN, data);
+					cs->epoll_want_write = false;
+				}
+			}
+			if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+				cs->ReceivePackets();
+			}
+		}
+		return _networking;
+	}
+#endif /* HAVE_EPOLL */
+
 public:
 	static bool ValidateClient(SOCKET s, NetworkAddress &address)
 	{
@@ -100,6 +177,10 @@ public:
 	 */
 	static bool Receive()
 	{
+#ifdef HAVE_EPOLL
+		if (epoll_fd >= 0) return ReceiveEpoll();
+#endif
+
 		fd_set read_fd, write_fd;
 		struct timeval tv;
 
@@ -157,6 +238,17 @@ public:
 			return false;
 		}
 
+#ifdef HAVE_EPOLL
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		if (epoll_fd < 0) {
+			DEBUG(net, 1, "[%s] epoll_create1 failed, falling back to select: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+		} else {
+			for (auto &s : sockets) {
+				EpollControl(EPOLL_CTL_ADD, s.second, EPOLLIN, EPOLL_LISTENER_TAG | (uint32)s.second);
+			}
+		}
+#endif
+
 		return true;
 	}
 
@@ -167,10 +259,23 @@ public:
 			closesocket(s.second);
 		}
 		sockets.clear();
+#ifdef HAVE_EPOLL
+		if (epoll_fd >= 0) {
+			close(epoll_fd);
+			epoll_fd = -1;
+			for (Tsocket *cs : Tsocket::Iterate()) {
+				cs->epoll_registered = false;
+				cs->epoll_want_write = false;
+			}
+		}
+#endif
 		DEBUG(net, 5, "[%s] Closed listeners", Tsocket::GetName());
 	}
 };
 
 template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketList TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::sockets;
+#ifdef HAVE_EPOLL
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> int TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::epoll_fd = -1;
+#endif
 
 #endif /* NETWORK_CORE_TCP_LISTEN_H */
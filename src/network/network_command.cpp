@@ -202,7 +202,7 @@ void NetworkSyncCommandQueue(NetworkClientSocket *cs)
 	for (CommandPacket *p = _local_execution_queue.Peek(); p != nullptr; p = p->next) {
 		CommandPacket c = *p;
 		c.callback = nullptr;
-		cs->outgoing_queue.Append(std::move(c));
+		cs->outgoing_queue.push_back(ServerNetworkGameSocketHandler::MakeCommandPacket(&c));
 	}
 }
 
@@ -258,13 +258,21 @@ static void DistributeCommandPacket(CommandPacket &cp, const NetworkClientSocket
 	CommandCallback *callback = cp.callback;
 	cp.frame = _frame_counter_max + 1;
 
+	/* All clients except the owner receive the same data, so only serialise it once. */
+	std::shared_ptr<const Packet> shared_packet;
+
 	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
 		if (cs->status >= NetworkClientSocket::STATUS_MAP) {
 			/* Callbacks are only send back to the client who sent them in the
 			 *  first place. This filters that out. */
 			cp.callback = (cs != owner) ? nullptr : callback;
 			cp.my_cmd = (cs == owner);
-			cs->outgoing_queue.Append(cp);
+			if (cs == owner) {
+				cs->outgoing_queue.push_back(ServerNetworkGameSocketHandler::MakeCommandPacket(&cp));
+			} else {
+				if (shared_packet == nullptr) shared_packet = ServerNetworkGameSocketHandler::MakeCommandPacket(&cp);
+				cs->outgoing_queue.push_back(shared_packet);
+			}
 		}
 	}
 
@@ -32,6 +32,7 @@
 #include "../crashlog.h"
 #include <mutex>
 #include <condition_variable>
+#include <deque>
 #if defined(__MINGW32__)
 #include "../3rdparty/mingw-std-threads/mingw.mutex.h"
 #include "../3rdparty/mingw-std-threads/mingw.condition_variable.h"
@@ -58,13 +59,26 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
+/**
+ * Writing a savegame directly to a number of packets.
+ * All clients that request the map in the same frame share a single savegame.
+ */
 struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
+	/** Progress of a single client through the packets of the savegame. */
+	struct User {
+		ServerNetworkGameSocketHandler *cs; ///< Socket of the client.
+		size_t next_packet;                 ///< Index of the next packet to transfer to the client.
+		bool map_size_sent;                 ///< Whether the map size packet has been transferred to the client.
+	};
+
+	std::vector<User> users;            ///< Clients receiving this savegame; saving is aborted when none are left.
+	uint32 frame;                       ///< Frame at which the savegame was made.
+	bool supports_zstd;                 ///< Whether the savegame may be compressed using zstd.
 	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
 	size_t total_size;                  ///< Total size of the compressed savegame.
-	std::vector<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame; send these "slowly" to the client.
-	std::unique_ptr<Packet> map_size_packet; ///< Map size packet, fast tracked to the client
+	std::deque<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame not yet transferred to all clients; send these "slowly" to the clients.
+	size_t first_packet;                ///< Index within the savegame of the front of the packet queue.
+	std::unique_ptr<Packet> map_size_packet; ///< Map size packet, fast tracked to the clients
 	std::mutex mutex;                   ///< Mutex for making threaded saving safe.
 	std::condition_variable exit_sig;   ///< Signal for threaded destruction of this packet writer.
 
@@ -72,8 +86,9 @@ struct PacketWriter : SaveFilter {
 	 * Create the packet writer.
 	 * @param cs The socket handler we're making the packets for.
 	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), cs(cs), total_size(0)
+	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), frame(_frame_counter), supports_zstd(cs->supports_zstd), total_size(0), first_packet(0)
 	{
+		this->users.push_back({ cs, 0, false });
 	}
 
 	/** Make sure everything is cleaned up. */
@@ -81,9 +96,8 @@ struct PacketWriter : SaveFilter {
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		if (this->cs != nullptr) this->exit_sig.wait(lock);
-
-		/* This must all wait until the Destroy function is called. */
+		/* This must all wait until the Destroy function is called by the last client. */
+		while (!this->users.empty()) this->exit_sig.wait(lock);
 
 		this->packets.clear();
 		this->map_size_packet.reset();
@@ -91,20 +105,82 @@ struct PacketWriter : SaveFilter {
 	}
 
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
+	 * Check whether a client can receive this savegame instead of starting a new one.
+	 * This is only possible in the frame the savegame was made, as the commands of
+	 * later frames would be missing for the new client.
+	 * @param cs The socket of the client that wants the map.
+	 * @return True iff the client can be added as user of this savegame.
+	 */
+	bool CanShareWith(const ServerNetworkGameSocketHandler *cs)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		return !this->users.empty() && this->frame == _frame_counter && this->supports_zstd == cs->supports_zstd;
+	}
+
+	/**
+	 * Add a client that receives this savegame too.
+	 * @param cs The socket of the client.
+	 * @pre CanShareWith(cs)
+	 */
+	void AddUser(ServerNetworkGameSocketHandler *cs)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		this->users.push_back({ cs, 0, false });
+	}
+
+	/**
+	 * Get the progress of a client.
+	 * @param cs The socket of the client.
+	 * @return Iterator to the client's progress.
+	 */
+	std::vector<User>::iterator FindUser(const ServerNetworkGameSocketHandler *cs)
+	{
+		auto it = std::find_if(this->users.begin(), this->users.end(), [cs](const User &user) { return user.cs == cs; });
+		assert(it != this->users.end());
+		return it;
+	}
+
+	/**
+	 * Free the packets that have been transferred to all clients.
+	 * In the frame the savegame was made packets are kept, so later clients of that frame can still join.
+	 */
+	void ReleaseTransferredPackets()
+	{
+		if (this->frame == _frame_counter || this->users.empty()) return;
+
+		size_t min_packet = SIZE_MAX;
+		for (const User &user : this->users) min_packet = std::min(min_packet, user.next_packet);
+
+		while (!this->packets.empty() && this->first_packet < min_packet) {
+			this->packets.pop_front();
+			this->first_packet++;
+		}
+	}
+
+	/**
+	 * Begin the destruction of this packet writer for a client. When other
+	 * clients are still receiving the savegame, only the client is removed.
+	 * Otherwise it can happen in two ways:
 	 * in the first case the client disconnected while saving the map. In this
 	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to nullptr, triggering the appending to fail due to
+	 * case we simply remove the last user, triggering the appending to fail due to
 	 * the connection problem and eventually triggering the destructor. In the
 	 * second case the destructor is already called, and it is waiting for our
 	 * signal which we will send. Only then the packets will be removed by the
 	 * destructor.
+	 * @param cs The socket of the client that does not need the savegame anymore.
 	 */
-	void Destroy()
+	void Destroy(ServerNetworkGameSocketHandler *cs)
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		this->cs = nullptr;
+		this->users.erase(this->FindUser(cs));
+		if (!this->users.empty()) {
+			this->ReleaseTransferredPackets();
+			return;
+		}
 
 		this->exit_sig.notify_all();
 		lock.unlock();
@@ -116,8 +192,9 @@ struct PacketWriter : SaveFilter {
 	}
 
 	/**
-	 * Transfer all packets from here to the network's queue while holding
-	 * the lock on our mutex.
+	 * Transfer all packets the client has not received yet from here to the
+	 * network's queue while holding the lock on our mutex.
+	 * Packets are only copied when another client still needs them.
 	 * @param socket The network socket to write to.
 	 * @return True iff the last packet of the map has been sent.
 	 */
@@ -125,17 +202,31 @@ struct PacketWriter : SaveFilter {
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		if (this->map_size_packet) {
+		User &user = *this->FindUser(socket);
+
+		if (this->map_size_packet != nullptr && !user.map_size_sent) {
 			/* Don't queue the PACKET_SERVER_MAP_SIZE before the corresponding PACKET_SERVER_MAP_BEGIN */
-			socket->SendPrependPacket(std::move(this->map_size_packet), PACKET_SERVER_MAP_BEGIN);
+			socket->SendPrependPacket(std::make_unique<Packet>(*this->map_size_packet), PACKET_SERVER_MAP_BEGIN);
+			user.map_size_sent = true;
 		}
+
+		const bool may_move = this->frame != _frame_counter;
 		bool last_packet = false;
-		for (auto &p : this->packets) {
+		for (; user.next_packet < this->first_packet + this->packets.size(); user.next_packet++) {
+			std::unique_ptr<Packet> &p = this->packets[user.next_packet - this->first_packet];
 			if (p->GetPacketType() == PACKET_SERVER_MAP_DONE) last_packet = true;
-			socket->SendPacket(std::move(p));
 
+			bool needed_by_others = std::any_of(this->users.begin(), this->users.end(), [&](const User &other) {
+				return &other != &user && other.next_packet <= user.next_packet;
+			});
+			if (may_move && !needed_by_others) {
+				socket->SendPacket(std::move(p));
+			} else {
+				socket->SendPacket(std::make_unique<Packet>(*p));
+			}
 		}
-		this->packets.clear();
+
+		this->ReleaseTransferredPackets();
 
 		return last_packet;
 	}
@@ -150,12 +241,12 @@ struct PacketWriter : SaveFilter {
 
 	void Write(byte *buf, size_t size) override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		std::lock_guard<std::mutex> lock(this->mutex);
 
-		if (this->current == nullptr) this->current.reset(new Packet(PACKET_SERVER_MAP_DATA, SHRT_MAX));
+		/* We want to abort the saving when the sockets are closed. */
+		if (this->users.empty()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->current == nullptr) this->current.reset(new Packet(PACKET_SERVER_MAP_DATA, SHRT_MAX));
 
 		byte *bufe = buf + size;
 		while (buf != bufe) {
@@ -173,11 +264,11 @@ struct PacketWriter : SaveFilter {
 
 	void Finish() override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
 		std::lock_guard<std::mutex> lock(this->mutex);
 
+		/* We want to abort the saving when the sockets are closed. */
+		if (this->users.empty()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+
 		/* Make sure the last packet is flushed. */
 		this->AppendQueue();
 
@@ -185,7 +276,7 @@ struct PacketWriter : SaveFilter {
 		this->current.reset(new Packet(PACKET_SERVER_MAP_DONE, SHRT_MAX));
 		this->AppendQueue();
 
-		/* Fast-track the size to the client. */
+		/* Fast-track the size to the clients. */
 		this->map_size_packet.reset(new Packet(PACKET_SERVER_MAP_SIZE, SHRT_MAX));
 		this->map_size_packet->Send_uint32((uint32)this->total_size);
 	}
@@ -223,7 +314,7 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 	RemoveVirtualTrainsOfUser(this->client_id);
 
 	if (this->savegame != nullptr) {
-		this->savegame->Destroy();
+		this->savegame->Destroy(this);
 		this->savegame = nullptr;
 	}
 }
@@ -272,8 +363,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 	/* If we were transfering a map to this client, stop the savegame creation
 	 * process and queue the next client to receive the map. */
 	if (this->status == STATUS_MAP) {
-		/* Ensure the saving of the game is stopped too. */
-		this->savegame->Destroy();
+		/* Ensure the saving of the game is stopped too, unless other clients still need it. */
+		this->savegame->Destroy(this);
 		this->savegame = nullptr;
 
 		this->CheckNextClientToSendMap(this);
@@ -548,28 +639,27 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
 
 void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocket *ignore_cs)
 {
-	/* Find the best candidate for joining, i.e. the first joiner. */
-	NetworkClientSocket *best = nullptr;
+	/* Wait until all clients sharing the current savegame are done. */
+	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
+		if (new_cs != ignore_cs && new_cs->status == STATUS_MAP) return;
+	}
+
+	/* Find the candidates for joining, in order of joining. */
+	std::vector<NetworkClientSocket *> waiting;
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
 		if (ignore_cs == new_cs) continue;
 
-		if (new_cs->status == STATUS_MAP_WAIT) {
-			if (best == nullptr || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
-				best = new_cs;
-			}
-		}
+		if (new_cs->status == STATUS_MAP_WAIT) waiting.push_back(new_cs);
 	}
+	std::sort(waiting.begin(), waiting.end(), [](const NetworkClientSocket *a, const NetworkClientSocket *b) {
+		if (a->GetInfo()->join_date != b->GetInfo()->join_date) return a->GetInfo()->join_date < b->GetInfo()->join_date;
+		return a->client_id < b->client_id;
+	});
 
-	/* Is there someone else to join? */
-	if (best != nullptr) {
-		/* Let the first start joining. */
-		best->status = STATUS_AUTHORIZED;
-		best->SendMap();
-
-		/* And update the rest. */
-		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-			if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
-		}
+	/* Let them all start joining; they share the savegame made for the first one where possible. */
+	for (NetworkClientSocket *new_cs : waiting) {
+		new_cs->status = STATUS_AUTHORIZED;
+		new_cs->SendMap();
 	}
 }
 
@@ -582,8 +672,23 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 	}
 
 	if (this->status == STATUS_AUTHORIZED) {
-		WaitTillSaved();
-		this->savegame = new PacketWriter(this);
+		/* Share the savegame of a client that requested the map in this same frame, if any. */
+		PacketWriter *shared = nullptr;
+		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
+			/* A client whose connection is being closed is still in STATUS_MAP, but has no savegame anymore. */
+			if (new_cs->status == STATUS_MAP && new_cs->savegame != nullptr && new_cs->savegame->CanShareWith(this)) {
+				shared = new_cs->savegame;
+				break;
+			}
+		}
+
+		if (shared != nullptr) {
+			shared->AddUser(this);
+			this->savegame = shared;
+		} else {
+			WaitTillSaved();
+			this->savegame = new PacketWriter(this);
+		}
 
 		/* Now send the _frame_counter and how many packets are coming */
 		Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN, SHRT_MAX);
@@ -596,17 +701,19 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 		this->last_frame = _frame_counter;
 		this->last_frame_server = _frame_counter;
 
-		/* Make a dump of the current game */
-		SaveModeFlags flags = SMF_NET_SERVER;
-		if (this->supports_zstd) flags |= SMF_ZSTD_OK;
-		if (SaveWithFilter(this->savegame, true, flags) != SL_OK) usererror("network savedump failed");
+		if (shared == nullptr) {
+			/* Make a dump of the current game */
+			SaveModeFlags flags = SMF_NET_SERVER;
+			if (this->supports_zstd) flags |= SMF_ZSTD_OK;
+			if (SaveWithFilter(this->savegame, true, flags) != SL_OK) usererror("network savedump failed");
+		}
 	}
 
 	if (this->status == STATUS_MAP) {
 		bool last_packet = this->savegame->TransferToNetworkQueue(this);
 		if (last_packet) {
 			/* Done reading, make sure saving is done as well */
-			this->savegame->Destroy();
+			this->savegame->Destroy(this);
 			this->savegame = nullptr;
 
 			/* Set the status to DONE_MAP, no we will wait for the client
@@ -633,8 +740,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendJoin(ClientID client_id)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Tell the client that they may run to a particular frame. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
+/** Create a frame packet, without the token. */
+static Packet *NewFramePacket()
 {
 	Packet *p = new Packet(PACKET_SERVER_FRAME, SHRT_MAX);
 	p->Send_uint32(_frame_counter);
@@ -646,20 +753,46 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 #endif
 	p->Send_uint64(_sync_state_checksum);
 #endif
+	return p;
+}
 
+/**
+ * Tell the client that they may run to a particular frame.
+ * @param shared_packet If not nullptr, a frame packet shared by all clients which do not need a new token this frame, created on first use.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame(std::shared_ptr<const Packet> *shared_packet)
+{
 	/* If token equals 0, we need to make a new token and send that. */
-	if (this->last_token == 0) {
-		this->last_token = InteractiveRandomRange(UINT8_MAX - 1) + 1;
-		p->Send_uint8(this->last_token);
+	if (this->last_token == 0 || shared_packet == nullptr) {
+		Packet *p = NewFramePacket();
+		if (this->last_token == 0) {
+			this->last_token = InteractiveRandomRange(UINT8_MAX - 1) + 1;
+			p->Send_uint8(this->last_token);
+		}
+		this->SendPacket(p);
+		return NETWORK_RECV_STATUS_OKAY;
 	}
 
-	this->SendPacket(p);
+	if (*shared_packet == nullptr) {
+		Packet *p = NewFramePacket();
+		p->PrepareToSend();
+		shared_packet->reset(p);
+	}
+	this->SendSharedPacket(*shared_packet);
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Request the client to sync. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
+/**
+ * Request the client to sync.
+ * @param shared_packet If not nullptr, a sync packet shared by all clients, created on first use.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync(std::shared_ptr<const Packet> *shared_packet)
 {
+	if (shared_packet != nullptr && *shared_packet != nullptr) {
+		this->SendSharedPacket(*shared_packet);
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	Packet *p = new Packet(PACKET_SERVER_SYNC, SHRT_MAX);
 	p->Send_uint32(_frame_counter);
 	p->Send_uint32(_sync_seed_1);
@@ -668,24 +801,33 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
 	p->Send_uint32(_sync_seed_2);
 #endif
 	p->Send_uint64(_sync_state_checksum);
-	this->SendPacket(p);
+
+	if (shared_packet != nullptr) {
+		p->PrepareToSend();
+		shared_packet->reset(p);
+		this->SendSharedPacket(*shared_packet);
+	} else {
+		this->SendPacket(p);
+	}
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
 /**
- * Send a command to the client to execute.
+ * Create a packet for a command for the clients to execute.
+ * The packet can be queued on all clients which should receive the same command data.
  * @param cp The command to send.
+ * @return The prepared packet.
  */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacket *cp)
+/* static */ std::shared_ptr<const Packet> ServerNetworkGameSocketHandler::MakeCommandPacket(const CommandPacket *cp)
 {
 	Packet *p = new Packet(PACKET_SERVER_COMMAND, SHRT_MAX);
 
-	this->NetworkGameSocketHandler::SendCommand(p, cp);
+	NetworkGameSocketHandler::SendCommand(p, cp);
 	p->Send_uint32(cp->frame);
 	p->Send_bool  (cp->my_cmd);
 
-	this->SendPacket(p);
-	return NETWORK_RECV_STATUS_OKAY;
+	p->PrepareToSend();
+	return std::shared_ptr<const Packet>(p);
 }
 
 /**
@@ -1034,14 +1176,20 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet *
 
 	this->supports_zstd = p->Recv_bool();
 
-	/* Check if someone else is receiving the map */
+	/* Check if someone else is receiving a map this client cannot share */
+	bool map_in_progress = false;
+	bool can_share = false;
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-		if (new_cs->status == STATUS_MAP) {
-			/* Tell the new client to wait */
-			this->status = STATUS_MAP_WAIT;
-			return this->SendWait();
+		if (new_cs->status == STATUS_MAP && new_cs->savegame != nullptr) {
+			map_in_progress = true;
+			if (new_cs->savegame->CanShareWith(this)) can_share = true;
 		}
 	}
+	if (map_in_progress && !can_share) {
+		/* Tell the new client to wait */
+		this->status = STATUS_MAP_WAIT;
+		return this->SendWait();
+	}
 
 	/* We receive a request to upload the map.. give it to the client! */
 	return this->SendMap();
@@ -1837,10 +1985,10 @@ void NetworkServerSetCompanyPassword(CompanyID company_id, const std::string &pa
  */
 static void NetworkHandleCommandQueue(NetworkClientSocket *cs)
 {
-	std::unique_ptr<CommandPacket> cp;
-	while ((cp = cs->outgoing_queue.Pop()) != nullptr) {
-		cs->SendCommand(cp.get());
+	for (auto &p : cs->outgoing_queue) {
+		cs->SendSharedPacket(std::move(p));
 	}
+	cs->outgoing_queue.clear();
 }
 
 /**
@@ -1849,6 +1997,12 @@ static void NetworkHandleCommandQueue(NetworkClientSocket *cs)
  */
 void NetworkServer_Tick(bool send_frame)
 {
+	/* The frame and sync packets are identical for all clients, so only create them once. */
+	std::shared_ptr<const Packet> frame_packet;
+#ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	std::shared_ptr<const Packet> sync_packet;
+#endif
+
 #ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
 	bool send_sync = false;
 #endif
@@ -1973,11 +2127,11 @@ void NetworkServer_Tick(bool send_frame)
 			NetworkHandleCommandQueue(cs);
 
 			/* Send an updated _frame_counter_max to the client */
-			if (send_frame) cs->SendFrame();
+			if (send_frame) cs->SendFrame(&frame_packet);
 
 #ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
 			/* Send a sync-check packet */
-			if (send_sync) cs->SendSync();
+			if (send_sync) cs->SendSync(&sync_packet);
 #endif
 		}
 	}
@@ -73,7 +73,7 @@ public:
 	byte last_token;             ///< The last random token we did send to verify the client is listening
 	uint32 last_token_frame;     ///< The last frame we received the right token
 	ClientStatus status;         ///< Status of this client
-	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
+	std::vector<std::shared_ptr<const Packet>> outgoing_queue; ///< The prepared command packets awaiting delivery
 	size_t receive_limit;        ///< Amount of bytes that we can receive at this moment
 	uint32 server_hash_bits;     ///< Server password hash entropy bits
 	uint32 rcon_hash_bits;       ///< Rcon password hash entropy bits
@@ -81,7 +81,7 @@ public:
 	bool settings_authed = false;///< Authorised to control all game settings
 	bool supports_zstd = false;  ///< Client supports zstd compression
 
-	struct PacketWriter *savegame; ///< Writer used to write the savegame.
+	struct PacketWriter *savegame; ///< Writer used to write the savegame, shared by all clients that requested the map in the same frame.
 	NetworkAddress client_address; ///< IP-address of the client (so they can be banned)
 
 	std::string desync_log;
@@ -110,15 +110,16 @@ public:
 	NetworkRecvStatus SendChat(NetworkAction action, ClientID client_id, bool self_send, const std::string &msg, NetworkTextMessageData data);
 	NetworkRecvStatus SendExternalChat(const std::string &source, TextColour colour, const std::string &user, const std::string &msg);
 	NetworkRecvStatus SendJoin(ClientID client_id);
-	NetworkRecvStatus SendFrame();
-	NetworkRecvStatus SendSync();
-	NetworkRecvStatus SendCommand(const CommandPacket *cp);
+	NetworkRecvStatus SendFrame(std::shared_ptr<const Packet> *shared_packet = nullptr);
+	NetworkRecvStatus SendSync(std::shared_ptr<const Packet> *shared_packet = nullptr);
 	NetworkRecvStatus SendCompanyUpdate();
 	NetworkRecvStatus SendConfigUpdate();
 	NetworkRecvStatus SendSettingsAccessUpdate(bool ok);
 
 	std::string GetDebugInfo() const override;
 
+	static std::shared_ptr<const Packet> MakeCommandPacket(const CommandPacket *cp);
+
 	static void Send();
 	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
 	static bool AllowConnection();
@@ -5356,6 +5356,8 @@ static void NewSpriteGroup(ByteReader *buf)
 				}
 			}
 
+			if (_newgrf_optimise_sprite_groups) group->Optimise();
+
 			break;
 		}
 
@@ -10101,7 +10103,7 @@ static void LoadNewGRFFileFromFile(GRFConfig *config, GrfLoadingStage stage, Spr
 	if (stage == GLS_INIT || stage == GLS_ACTIVATION) {
 		/* We need the sprite offsets in the init stage for NewGRF sounds
 		 * and in the activation stage for real sprites. */
-		ReadGRFSpriteOffsets(file);
+		ReadGRFSpriteOffsets(file, config->ident.md5sum);
 	} else {
 		/* Skip sprite section offset if present. */
 		if (grf_container_version >= 2) file.ReadDword();
@@ -23,6 +23,8 @@ INSTANTIATE_POOL_METHODS(SpriteGroup)
 
 TemporaryStorageArray<int32, 0x110> _temp_store;
 
+bool _newgrf_optimise_sprite_groups = true; ///< Whether to constant fold deterministic sprite groups when loading NewGRFs.
+
 
 /**
  * ResolverObject (re)entry point.
@@ -259,6 +261,183 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 	return SpriteGroup::Resolve(this->default_group, object, false);
 }
 
+/**
+ * Check whether an adjust of a variable with a constant value can be evaluated
+ * in advance, i.e. it has no side effects and can't trap.
+ * @param adjust Adjust to check.
+ * @return True if the adjust can be folded.
+ */
+template <typename U, typename S>
+static bool CanFoldConstantAdjustT(const DeterministicSpriteGroupAdjust &adjust)
+{
+	if (adjust.variable != 0x1A) return false;
+	if (adjust.type != DSGA_TYPE_NONE && ((S)adjust.divmod_val == 0 || (S)adjust.divmod_val == -1)) return false;
+
+	switch (adjust.operation) {
+		case DSGA_OP_STO:
+		case DSGA_OP_STOP:
+		case DSGA_OP_SDIV:
+		case DSGA_OP_SMOD:
+			return false;
+
+		default:
+			return adjust.operation < DSGA_OP_END;
+	}
+}
+
+/**
+ * Check that optimising a deterministic sprite group did not change what it resolves to.
+ * Variables other than 0x1A are replaced by sample values, chains which store values,
+ * call procedures or may divide by -1 are only checked for not being treated as constant.
+ * @param group Optimised group.
+ * @param original_adjusts Adjusts before optimisation.
+ * @param original_ranges Ranges before optimisation.
+ * @param original_default_group Default group before optimisation.
+ * @return False iff the optimised group resolves differently.
+ */
+template <typename U, typename S>
+static bool CheckOptimisedDeterministicSpriteGroupT(const DeterministicSpriteGroup *group, const std::vector<DeterministicSpriteGroupAdjust> &original_adjusts,
+		const std::vector<DeterministicSpriteGroupRange> &original_ranges, const SpriteGroup *original_default_group)
+{
+	const bool all_constant = std::all_of(original_adjusts.begin(), original_adjusts.end(), [](const DeterministicSpriteGroupAdjust &adjust) {
+		return adjust.variable == 0x1A;
+	});
+	if (!all_constant) {
+		/* A chain which reads a real variable must still select its range when resolved. */
+		if (group->ranges.size() != original_ranges.size() || group->default_group != original_default_group) return false;
+	}
+
+	auto can_evaluate = [](const DeterministicSpriteGroupAdjust &adjust) {
+		if (adjust.variable == 0x7E || adjust.variable == 0x7B) return false;
+		if (adjust.type != DSGA_TYPE_NONE && ((S)adjust.divmod_val == 0 || (S)adjust.divmod_val == -1)) return false;
+		switch (adjust.operation) {
+			case DSGA_OP_STO:
+			case DSGA_OP_STOP:
+			case DSGA_OP_SDIV:
+			case DSGA_OP_SMOD:
+				return false;
+
+			default:
+				return true;
+		}
+	};
+	if (!std::all_of(original_adjusts.begin(), original_adjusts.end(), can_evaluate)) return true;
+	if (!std::all_of(group->adjusts.begin(), group->adjusts.end(), can_evaluate)) return true;
+
+	auto evaluate = [](const std::vector<DeterministicSpriteGroupAdjust> &adjusts, uint32 sample) -> uint32 {
+		uint32 last_value = 0;
+		for (const auto &adjust : adjusts) {
+			last_value = EvalAdjustT<U, S>(adjust, nullptr, last_value, adjust.variable == 0x1A ? UINT_MAX : sample);
+		}
+		return last_value;
+	};
+	auto select = [](const std::vector<DeterministicSpriteGroupRange> &ranges, const SpriteGroup *default_group, uint32 value) {
+		for (const auto &range : ranges) {
+			if (range.low <= value && value <= range.high) return range.group;
+		}
+		return default_group;
+	};
+
+	for (uint32 sample : { 0U, 1U, 0x55U, 0xFFFFU, UINT_MAX }) {
+		const uint32 original_value = evaluate(original_adjusts, sample);
+		const uint32 optimised_value = evaluate(group->adjusts, sample);
+		if (original_value != optimised_value) return false;
+		if (!group->calculated_result && select(original_ranges, original_default_group, original_value) != select(group->ranges, group->default_group, optimised_value)) return false;
+	}
+	return true;
+}
+
+/**
+ * Constant fold the adjusts of a deterministic sprite group.
+ * Variable 0x1A is always -1, so the operand of adjusts using it can be
+ * computed in advance, and a run of such adjusts at the start of the chain
+ * can be replaced by a single constant. If the whole chain is constant, the
+ * range lookup is done in advance too.
+ * @param group Group to optimise.
+ */
+template <typename U, typename S>
+static void OptimiseDeterministicSpriteGroupT(DeterministicSpriteGroup *group)
+{
+	std::vector<DeterministicSpriteGroupAdjust> &adjusts = group->adjusts;
+
+	/* Checking the result of the optimisation is costly, so only do it when NewGRF debugging is enabled. */
+	const bool check = _debug_grf_level >= 6;
+	std::vector<DeterministicSpriteGroupAdjust> original_adjusts;
+	std::vector<DeterministicSpriteGroupRange> original_ranges;
+	const SpriteGroup *original_default_group = group->default_group;
+	if (check) {
+		original_adjusts = adjusts;
+		original_ranges = group->ranges;
+	}
+
+	/* Fold the leading constant adjusts. */
+	uint32 last_value = 0;
+	size_t folded = 0;
+	while (folded < adjusts.size() && CanFoldConstantAdjustT<U, S>(adjusts[folded])) {
+		last_value = EvalAdjustT<U, S>(adjusts[folded], nullptr, last_value, UINT_MAX);
+		folded++;
+	}
+	/* Whether the whole chain is constant, this must be determined before the folded adjusts are removed. */
+	const bool all_constant = (folded == adjusts.size());
+	if (folded > 0) {
+		DeterministicSpriteGroupAdjust constant = {};
+		constant.operation = DSGA_OP_RST;
+		constant.type = DSGA_TYPE_NONE;
+		constant.variable = 0x1A;
+		constant.and_mask = last_value;
+		adjusts.erase(adjusts.begin() + 1, adjusts.begin() + folded);
+		adjusts[0] = constant;
+	}
+
+	/* Pre-compute the operand of the remaining constant adjusts. */
+	for (DeterministicSpriteGroupAdjust &adjust : adjusts) {
+		if (adjust.variable != 0x1A || (adjust.shift_num == 0 && adjust.type == DSGA_TYPE_NONE)) continue;
+		if (adjust.type != DSGA_TYPE_NONE && ((S)adjust.divmod_val == 0 || (S)adjust.divmod_val == -1)) continue;
+
+		/* The same operand as computed by EvalAdjustT. */
+		uint32 value = UINT_MAX >> adjust.shift_num;
+		value &= adjust.and_mask;
+		switch (adjust.type) {
+			case DSGA_TYPE_DIV:  value = ((S)value + (S)adjust.add_val) / (S)adjust.divmod_val; break;
+			case DSGA_TYPE_MOD:  value = ((S)value + (S)adjust.add_val) % (S)adjust.divmod_val; break;
+			case DSGA_TYPE_NONE: break;
+		}
+		adjust.shift_num = 0;
+		adjust.type = DSGA_TYPE_NONE;
+		adjust.and_mask = value;
+		adjust.add_val = 0;
+		adjust.divmod_val = 0;
+	}
+
+	/* The whole chain is constant, so is the chosen range. */
+	if (all_constant && !group->calculated_result) {
+		for (const auto &range : group->ranges) {
+			if (range.low <= last_value && last_value <= range.high) {
+				group->default_group = range.group;
+				break;
+			}
+		}
+		group->ranges.clear();
+	}
+
+	if (check && !CheckOptimisedDeterministicSpriteGroupT<U, S>(group, original_adjusts, original_ranges, original_default_group)) {
+		DEBUG(grf, 0, "Optimising the deterministic sprite group of NFO line %u changed its result", group->nfo_line);
+	}
+}
+
+/**
+ * Optimise the group after it has been loaded. The result of resolving the group is not changed.
+ */
+void DeterministicSpriteGroup::Optimise()
+{
+	switch (this->size) {
+		case DSG_SIZE_BYTE:  OptimiseDeterministicSpriteGroupT<uint8,  int8> (this); break;
+		case DSG_SIZE_WORD:  OptimiseDeterministicSpriteGroupT<uint16, int16>(this); break;
+		case DSG_SIZE_DWORD: OptimiseDeterministicSpriteGroupT<uint32, int32>(this); break;
+		default: NOT_REACHED();
+	}
+}
+
 void DeterministicSpriteGroup::AnalyseCallbacks(AnalyseCallbackOperation &op) const
 {
 	auto res = op.seen.insert(this);
@@ -198,11 +198,14 @@ struct DeterministicSpriteGroup : SpriteGroup {
 	const SpriteGroup *error_group; // was first range, before sorting ranges
 
 	void AnalyseCallbacks(AnalyseCallbackOperation &op) const override;
+	void Optimise();
 
 protected:
 	const SpriteGroup *Resolve(ResolverObject &object) const override;
 };
 
+extern bool _newgrf_optimise_sprite_groups;
+
 enum RandomizedSpriteGroupCompareMode {
 	RSG_CMP_ANY,
 	RSG_CMP_ALL,
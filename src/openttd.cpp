@@ -1787,6 +1787,7 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 
 		if (_order_destination_refcount_map_valid) {
 			btree::btree_map<uint32, uint32> saved_order_destination_refcount_map = std::move(_order_destination_refcount_map);
+			btree::btree_map<uint64, uint32> saved_order_destination_orderlist_map = std::move(_order_destination_orderlist_map);
 			for (auto iter = saved_order_destination_refcount_map.begin(); iter != saved_order_destination_refcount_map.end();) {
 				if (iter->second == 0) {
 					iter = saved_order_destination_refcount_map.erase(iter);
@@ -1796,6 +1797,7 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 			}
 			IntialiseOrderDestinationRefcountMap();
 			if (saved_order_destination_refcount_map != _order_destination_refcount_map) CCLOG("Order destination refcount map mismatch");
+			if (saved_order_destination_orderlist_map != _order_destination_orderlist_map) CCLOG("Order destination order list map mismatch");
 		} else {
 			CCLOG("Order destination refcount map not valid");
 		}
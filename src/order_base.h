@@ -47,6 +47,31 @@ template <typename F> void IterateOrderRefcountMapForDestinationID(DestinationID
 	}
 }
 
+extern btree::btree_map<uint64, uint32> _order_destination_orderlist_map;
+
+inline uint64 OrderDestinationOrderListMapKey(DestinationID dest, bool depot, OrderListID list)
+{
+	static_assert(sizeof(dest) == 2);
+	static_assert(sizeof(list) == 2);
+	return (((uint64) depot) << 32) | (((uint64) dest) << 16) | ((uint64) list);
+}
+
+/**
+ * Iterate the order lists which have at least one order to the given destination.
+ * This is only valid when _order_destination_refcount_map_valid is true.
+ * @param dest Destination ID, this is a StationID for station, waypoint, implicit and hangar orders, and a DepotID for other depot orders.
+ * @param depot True to iterate non-nearest depot orders, false to iterate station, waypoint and implicit orders.
+ * @param handler Functor with signature: void (OrderListID)
+ */
+template <typename F> void IterateOrderListsForDestination(DestinationID dest, bool depot, F handler)
+{
+	const uint64 prefix = OrderDestinationOrderListMapKey(dest, depot, 0);
+	for (auto lb = _order_destination_orderlist_map.lower_bound(prefix); lb != _order_destination_orderlist_map.end(); ++lb) {
+		if ((lb->first >> 16) != (prefix >> 16)) return;
+		handler((OrderListID) GB(lb->first, 0, 16));
+	}
+}
+
 void IntialiseOrderDestinationRefcountMap();
 void ClearOrderDestinationRefcountMap();
 
@@ -54,6 +54,7 @@ OrderListPool _orderlist_pool("OrderList");
 INSTANTIATE_POOL_METHODS(OrderList)
 
 btree::btree_map<uint32, uint32> _order_destination_refcount_map;
+btree::btree_map<uint64, uint32> _order_destination_orderlist_map;
 bool _order_destination_refcount_map_valid = false;
 
 CommandCost CmdInsertOrderIntl(DoCommandFlag flags, Vehicle *v, VehicleOrderID sel_ord, const Order &new_order, bool allow_load_by_cargo_type);
@@ -66,6 +67,9 @@ void IntialiseOrderDestinationRefcountMap()
 		for(const Order *order : v->Orders()) {
 			if (order->IsType(OT_GOTO_STATION) || order->IsType(OT_GOTO_WAYPOINT) || order->IsType(OT_IMPLICIT)) {
 				_order_destination_refcount_map[OrderDestinationRefcountMapKey(order->GetDestination(), v->owner, order->GetType(), v->type)]++;
+				_order_destination_orderlist_map[OrderDestinationOrderListMapKey(order->GetDestination(), false, v->orders.list->index)]++;
+			} else if (order->IsType(OT_GOTO_DEPOT) && !(order->GetDepotActionType() & ODATFB_NEAREST_DEPOT)) {
+				_order_destination_orderlist_map[OrderDestinationOrderListMapKey(order->GetDestination(), true, v->orders.list->index)]++;
 			}
 		}
 	}
@@ -75,13 +79,29 @@ void IntialiseOrderDestinationRefcountMap()
 void ClearOrderDestinationRefcountMap()
 {
 	_order_destination_refcount_map.clear();
+	_order_destination_orderlist_map.clear();
 	_order_destination_refcount_map_valid = false;
 }
 
-void UpdateOrderDestinationRefcount(const Order *order, VehicleType type, Owner owner, int delta)
+static void UpdateOrderDestinationOrderListMap(uint64 key, int delta)
+{
+	if (delta > 0) {
+		_order_destination_orderlist_map[key] += delta;
+	} else {
+		auto iter = _order_destination_orderlist_map.find(key);
+		assert(iter != _order_destination_orderlist_map.end() && iter->second >= (uint32)(-delta));
+		iter->second += delta;
+		if (iter->second == 0) _order_destination_orderlist_map.erase(iter);
+	}
+}
+
+void UpdateOrderDestinationRefcount(const Order *order, VehicleType type, Owner owner, OrderListID list, int delta)
 {
 	if (order->IsType(OT_GOTO_STATION) || order->IsType(OT_GOTO_WAYPOINT) || order->IsType(OT_IMPLICIT)) {
 		_order_destination_refcount_map[OrderDestinationRefcountMapKey(order->GetDestination(), owner, order->GetType(), type)] += delta;
+		UpdateOrderDestinationOrderListMap(OrderDestinationOrderListMapKey(order->GetDestination(), false, list), delta);
+	} else if (order->IsType(OT_GOTO_DEPOT) && !(order->GetDepotActionType() & ODATFB_NEAREST_DEPOT)) {
+		UpdateOrderDestinationOrderListMap(OrderDestinationOrderListMapKey(order->GetDestination(), true, list), delta);
 	}
 }
 
@@ -446,7 +466,7 @@ void OrderList::Initialize(Order *chain, Vehicle *v)
 			this->total_duration += o->GetWaitTime() + o->GetTravelTime();
 		}
 		this->order_index.push_back(o);
-		RegisterOrderDestination(o, type, owner);
+		RegisterOrderDestination(o, type, owner, this->index);
 	}
 
 	for (Vehicle *u = this->first_shared->PreviousShared(); u != nullptr; u = u->PreviousShared()) {
@@ -482,7 +502,7 @@ void OrderList::FreeChain(bool keep_orderlist)
 	VehicleType type = this->GetFirstSharedVehicle()->type;
 	Owner owner = this->GetFirstSharedVehicle()->owner;
 	for (Order *o = this->first; o != nullptr; o = next) {
-		UnregisterOrderDestination(o, type, owner);
+		UnregisterOrderDestination(o, type, owner, this->index);
 		next = o->next;
 		delete o;
 	}
@@ -687,7 +707,7 @@ void OrderList::InsertOrderAt(Order *new_order, int index)
 		this->timetable_duration += new_order->GetTimetabledWait() + new_order->GetTimetabledTravel();
 		this->total_duration += new_order->GetWaitTime() + new_order->GetTravelTime();
 	}
-	RegisterOrderDestination(new_order, this->GetFirstSharedVehicle()->type, this->GetFirstSharedVehicle()->owner);
+	RegisterOrderDestination(new_order, this->GetFirstSharedVehicle()->type, this->GetFirstSharedVehicle()->owner, this->index);
 	this->ReindexOrderList();
 
 	/* We can visit oil rigs and buoys that are not our own. They will be shown in
@@ -723,7 +743,7 @@ void OrderList::DeleteOrderAt(int index)
 		this->timetable_duration -= (to_remove->GetTimetabledWait() + to_remove->GetTimetabledTravel());
 		this->total_duration -= (to_remove->GetWaitTime() + to_remove->GetTravelTime());
 	}
-	UnregisterOrderDestination(to_remove, this->GetFirstSharedVehicle()->type, this->GetFirstSharedVehicle()->owner);
+	UnregisterOrderDestination(to_remove, this->GetFirstSharedVehicle()->type, this->GetFirstSharedVehicle()->owner, this->index);
 	delete to_remove;
 	this->ReindexOrderList();
 }
@@ -14,16 +14,16 @@
 #include "order_func.h"
 #include "vehicle_base.h"
 
-void UpdateOrderDestinationRefcount(const Order *order, VehicleType type, Owner owner, int delta);
+void UpdateOrderDestinationRefcount(const Order *order, VehicleType type, Owner owner, OrderListID list, int delta);
 
-inline void RegisterOrderDestination(const Order *order, VehicleType type, Owner owner)
+inline void RegisterOrderDestination(const Order *order, VehicleType type, Owner owner, OrderListID list)
 {
-	if (_order_destination_refcount_map_valid) UpdateOrderDestinationRefcount(order, type, owner, 1);
+	if (_order_destination_refcount_map_valid) UpdateOrderDestinationRefcount(order, type, owner, list, 1);
 }
 
-inline void UnregisterOrderDestination(const Order *order, VehicleType type, Owner owner)
+inline void UnregisterOrderDestination(const Order *order, VehicleType type, Owner owner, OrderListID list)
 {
-	if (_order_destination_refcount_map_valid) UpdateOrderDestinationRefcount(order, type, owner, -1);
+	if (_order_destination_refcount_map_valid) UpdateOrderDestinationRefcount(order, type, owner, list, -1);
 }
 
 /**
@@ -50,7 +50,7 @@ restart:
 				break;
 			}
 
-			UnregisterOrderDestination(order, v->type, v->owner);
+			UnregisterOrderDestination(order, v->type, v->owner, v->orders.list->index);
 
 			/* Clear wait time */
 			if (!order->IsType(OT_CONDITIONAL)) v->orders.list->UpdateTotalDuration(-static_cast<Ticks>(order->GetWaitTime()));
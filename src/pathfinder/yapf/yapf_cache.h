@@ -12,6 +12,8 @@
 
 #include "../../track_type.h"
 
+struct OrthogonalTileArea;
+
 /**
  * Use this function to notify YAPF that track layout (or signal configuration) has change.
  * @param tile  the tile that is changed
@@ -19,4 +21,10 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the track layout of a whole area has changed.
+ * @param area the area that is changed
+ */
+void YapfNotifyTrackLayoutAreaChange(const OrthogonalTileArea &area);
+
 #endif /* YAPF_CACHE_H */
@@ -11,6 +11,8 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../tilearea_type.h"
+#include <vector>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -91,20 +93,31 @@ public:
 
 
 /**
- * Base class for segment cost cache providers. Contains global counter
- *  of track layout changes and static notification function called whenever
- *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function.
+ * Base class for segment cost cache providers. Keeps track of the areas in
+ *  which the track layout changed since each cache was last used, and contains
+ *  the static notification functions called whenever the track layout changes.
+ *  It is implemented as base class because it needs to be shared between all
+ *  rail YAPF types (one registry of caches, one notification function).
  */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	/** Above this number of pending changed areas the whole cache is flushed instead. */
+	static const uint MAX_PENDING_CHANGES = 256;
 
-	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
-	{
-		s_rail_change_counter++;
-	}
+	static uint64 s_hits;   ///< number of segments fetched from a global cache which had valid cached data
+	static uint64 s_misses; ///< number of segments fetched from a global cache which had to be calculated
+
+	std::vector<TileArea> m_pending_changes; ///< areas changed since the cache was last used
+	bool                  m_flush_pending;   ///< the whole cache must be flushed before it is used again
+
+	CSegmentCostCacheBase();
+	~CSegmentCostCacheBase();
+
+	static void NotifyTrackLayoutChange(TileIndex tile, Track track);
+	static void NotifyTrackLayoutAreaChange(const TileArea &area);
+
+private:
+	static std::vector<CSegmentCostCacheBase *> &GetCaches();
 };
 
 
@@ -138,6 +151,35 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 		m_heap.Clear();
 	}
 
+	/**
+	 * Invalidate all cached segments which may depend on the areas changed since the last call.
+	 * Segments are kept in the hash table (and thus in the heap), only their cached data is reset.
+	 */
+	inline void ProcessPendingChanges()
+	{
+		if (m_flush_pending) {
+			Flush();
+		} else if (!m_pending_changes.empty()) {
+			TileArea bounds;
+			for (const TileArea &area : m_pending_changes) {
+				bounds.Add(area.tile);
+				bounds.Add(TILE_ADDXY(area.tile, area.w - 1, area.h - 1));
+			}
+			for (uint i = 0; i < m_heap.Length(); i++) {
+				Tsegment &segment = m_heap[i];
+				if (!segment.IsAffectedBy(bounds)) continue;
+				for (const TileArea &area : m_pending_changes) {
+					if (segment.IsAffectedBy(area)) {
+						segment.Invalidate();
+						break;
+					}
+				}
+			}
+		}
+		m_pending_changes.clear();
+		m_flush_pending = false;
+	}
+
 	inline Tsegment& Get(Key &key, bool *found)
 	{
 		Tsegment *item = m_map.Find(key);
@@ -181,14 +223,10 @@ protected:
 
 	inline static Cache& stGetGlobalCache()
 	{
-		static int last_rail_change_counter = 0;
 		static Cache C;
 
-		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
-		}
+		/* invalidate the segments affected by track layout changes */
+		C.ProcessPendingChanges();
 		return C;
 	}
 
@@ -206,6 +244,12 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		found = found && item.m_cost >= 0;
+		if (found) {
+			Cache::s_hits++;
+		} else {
+			Cache::s_misses++;
+		}
 		return found;
 	}
 
@@ -599,6 +599,9 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Remember the tiles the segment depends on, to be able to invalidate it when they change. */
+			segment.m_area.Add(cur.tile);
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -715,7 +718,9 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			tf = &tf_local;
 			tf_local.Init(v, Yapf().GetCompatibleRailTypes());
 
-			if (!tf_local.Follow(cur.tile, cur.td)) {
+			bool follow_ok = tf_local.Follow(cur.tile, cur.td);
+			if (tf_local.m_new_tile != INVALID_TILE) segment.m_area.Add(tf_local.m_new_tile);
+			if (!follow_ok) {
 				assert(tf_local.m_err != TrackFollower::EC_NONE);
 				/* Can't move to the next tile (EOL?). */
 				if (!(end_segment_reason & (ESRB_RAIL_TYPE | ESRB_DEAD_END))) end_segment_reason |= ESRB_DEAD_END_EOL;
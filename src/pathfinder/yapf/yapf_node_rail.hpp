@@ -69,6 +69,7 @@ struct CYapfRailSegment
 	TileIndex              m_last_signal_tile;
 	Trackdir               m_last_signal_td;
 	EndSegmentReasonBits   m_end_segment_reason;
+	TileArea               m_area;        ///< bounding box of all tiles inspected while calculating the segment
 	CYapfRailSegment      *m_hash_next;
 
 	inline CYapfRailSegment(const CYapfRailSegmentKey &key)
@@ -82,6 +83,27 @@ struct CYapfRailSegment
 		, m_hash_next(nullptr)
 	{}
 
+	/**
+	 * Does a change of the track layout in the given area affect the cached data of this segment?
+	 * @param area the changed area, already expanded to cover the neighbouring tiles
+	 */
+	inline bool IsAffectedBy(const TileArea &area) const
+	{
+		return m_cost >= 0 && m_area.Intersects(area);
+	}
+
+	/** Throw away the cached data, keeping the segment key and position in the hash table. */
+	inline void Invalidate()
+	{
+		m_last_tile = INVALID_TILE;
+		m_last_td = INVALID_TRACKDIR;
+		m_cost = -1;
+		m_last_signal_tile = INVALID_TILE;
+		m_last_signal_td = INVALID_TRACKDIR;
+		m_end_segment_reason = ESRB_NONE;
+		m_area.Clear();
+	}
+
 	inline const Key& GetKey() const
 	{
 		return m_key;
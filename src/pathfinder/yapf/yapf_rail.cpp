@@ -223,7 +223,10 @@ public:
 		if (target != nullptr) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			/* Only the cached segments around the newly reserved path need to be recalculated. */
+			for (Node *node = m_res_node; node != nullptr; node = node->m_parent) {
+				if (node->m_segment != nullptr) YapfNotifyTrackLayoutAreaChange(node->m_segment->m_area);
+			}
 		}
 
 		return true;
@@ -780,14 +783,90 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
-int CSegmentCostCacheBase::s_rail_change_counter = 0;
+uint64 CSegmentCostCacheBase::s_hits = 0;
+uint64 CSegmentCostCacheBase::s_misses = 0;
+
+/** All segment cost caches which have to be told about track layout changes. */
+std::vector<CSegmentCostCacheBase *> &CSegmentCostCacheBase::GetCaches()
+{
+	static std::vector<CSegmentCostCacheBase *> caches;
+	return caches;
+}
+
+CSegmentCostCacheBase::CSegmentCostCacheBase() : m_flush_pending(false)
+{
+	GetCaches().push_back(this);
+}
+
+CSegmentCostCacheBase::~CSegmentCostCacheBase()
+{
+	std::vector<CSegmentCostCacheBase *> &caches = GetCaches();
+	caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+}
+
+/**
+ * Record a track layout change on a single tile, or of the whole map if tile is INVALID_TILE.
+ * A change of a tunnel or bridge head also covers the other end of the tunnel or bridge.
+ */
+void CSegmentCostCacheBase::NotifyTrackLayoutChange(TileIndex tile, Track track)
+{
+	if (tile == INVALID_TILE) {
+		for (CSegmentCostCacheBase *cache : GetCaches()) {
+			cache->m_pending_changes.clear();
+			cache->m_flush_pending = true;
+		}
+		return;
+	}
+
+	TileArea area(tile, 1, 1);
+	if (IsTileType(tile, MP_TUNNELBRIDGE)) area.Add(GetOtherTunnelBridgeEnd(tile));
+	NotifyTrackLayoutAreaChange(area);
+}
+
+/**
+ * Record a track layout change of an area, the segments touching it are invalidated the next time the caches are used.
+ */
+void CSegmentCostCacheBase::NotifyTrackLayoutAreaChange(const TileArea &area)
+{
+	if (area.tile == INVALID_TILE) return;
+
+	/* Segments also depend on the tiles just beyond their ends. */
+	TileArea expanded = area;
+	expanded.Expand(1);
+
+	for (CSegmentCostCacheBase *cache : GetCaches()) {
+		if (cache->m_flush_pending) continue;
+		if (cache->m_pending_changes.size() >= MAX_PENDING_CHANGES) {
+			/* Too many changes to check individually, just start over. */
+			cache->m_pending_changes.clear();
+			cache->m_flush_pending = true;
+		} else {
+			cache->m_pending_changes.push_back(expanded);
+		}
+	}
+}
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
 }
 
+void YapfNotifyTrackLayoutAreaChange(const TileArea &area)
+{
+	CSegmentCostCacheBase::NotifyTrackLayoutAreaChange(area);
+}
+
+/**
+ * Get the statistics of the rail segment cost caches.
+ * @param[out] misses number of segments which had to be calculated
+ * @return number of segments which were found in the caches
+ */
+uint64 GetYapfRailSegmentCacheStats(uint64 &misses)
+{
+	misses = CSegmentCostCacheBase::s_misses;
+	return CSegmentCostCacheBase::s_hits;
+}
+
 void YapfCheckRailSignalPenalties()
 {
 	bool negative = false;
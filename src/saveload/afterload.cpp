@@ -636,6 +636,9 @@ bool AfterLoadGame()
 	RebuildStationKdtree();
 	UpdateCachedSnowLine();
 
+	/* The vehicle tile hash is sized to the map, which has only now been loaded. */
+	ResetVehicleHash();
+
 	_viewport_sign_kdtree_valid = false;
 
 	if (IsSavegameVersionBefore(SLV_98)) GamelogGRFAddList(_grfconfig);
@@ -3920,6 +3923,8 @@ bool AfterLoadGame()
 
 	if (SlXvIsFeatureMissing(XSLFI_ANIMATED_TILE_EXTRA)) {
 		UpdateAllAnimatedTileSpeeds();
+	} else {
+		RebuildAnimatedTileBuckets();
 	}
 
 	if (!SlXvIsFeaturePresent(XSLFI_REALISTIC_TRAIN_BRAKING, 2)) {
@@ -4069,7 +4074,8 @@ void ReloadNewGRFData()
 		rail_type_label_map[rt] = GetRailTypeInfo(rt)->label;
 	}
 
-	/* reload grf data */
+	/* reload grf data, the files may have changed on disk since they were last read */
+	ClearGRFSpriteOffsetsCache(nullptr);
 	GfxLoadSprites();
 	LoadStringWidthTable();
 	RecomputePrices();
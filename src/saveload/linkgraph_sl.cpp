@@ -23,6 +23,7 @@ typedef LinkGraph::BaseEdge Edge;
 const SettingDesc *GetSettingDescription(uint index);
 
 static uint16 _num_nodes;
+static NodeID _next_edge; ///< Destination of the next edge of the node being saved/loaded.
 
 /**
  * Get a SaveLoad array for a link graph.
@@ -128,7 +129,7 @@ static const SaveLoad _edge_desc[] = {
 	     SLE_VAR(Edge, usage,                    SLE_UINT32),
 	     SLE_VAR(Edge, last_unrestricted_update, SLE_INT32),
 	 SLE_CONDVAR(Edge, last_restricted_update,   SLE_INT32, SLV_187, SL_MAX_VERSION),
-	     SLE_VAR(Edge, next_edge,                SLE_UINT16),
+	    SLEG_VAR(_next_edge,                     SLE_UINT16),
 };
 
 std::vector<SaveLoad> _filtered_node_desc;
@@ -152,13 +153,47 @@ void Save_LinkGraph(LinkGraph &lg)
 	for (NodeID from = 0; from < size; ++from) {
 		Node *node = &lg.nodes[from];
 		SlObjectSaveFiltered(node, _filtered_node_desc);
-		/* ... but as that wasted a lot of space we save a sparse matrix now. */
-		for (NodeID to = from; to != INVALID_NODE; to = lg.edges[from][to].next_edge) {
-			SlObjectSaveFiltered(&lg.edges[from][to], _filtered_edge_desc);
+		/* The edges are saved as a list linked by next_edge, starting at an empty edge from the node to itself. */
+		Edge head;
+		head.Init(from);
+		_next_edge = node->edges.empty() ? INVALID_NODE : node->edges.front().dest_node;
+		SlObjectSaveFiltered(&head, _filtered_edge_desc);
+		for (size_t i = 0; i < node->edges.size(); i++) {
+			_next_edge = (i + 1 < node->edges.size()) ? node->edges[i + 1].dest_node : INVALID_NODE;
+			SlObjectSaveFiltered(&node->edges[i], _filtered_edge_desc);
 		}
 	}
 }
 
+/**
+ * Add a loaded edge to a node, if it is a real link.
+ * @param node Node the edge starts at.
+ * @param from ID of the node.
+ * @param to Destination of the edge.
+ * @param edge Loaded edge.
+ */
+static void AddLoadedEdge(Node *node, NodeID from, NodeID to, Edge edge)
+{
+	if (to == from) return;
+	edge.dest_node = to;
+	node->edges.push_back(edge);
+}
+
+/**
+ * Sort the loaded edges of a node by destination.
+ * @param node Node whose edges were loaded.
+ */
+static void SortLoadedEdges(Node *node)
+{
+	std::sort(node->edges.begin(), node->edges.end(), [](const Edge &a, const Edge &b) {
+		return a.dest_node < b.dest_node;
+	});
+	auto dup = std::adjacent_find(node->edges.begin(), node->edges.end(), [](const Edge &a, const Edge &b) {
+		return a.dest_node == b.dest_node;
+	});
+	if (dup != node->edges.end()) SlErrorCorrupt("Duplicate link graph edge");
+}
+
 /**
  * Load a link graph.
  * @param lg Link graph to be saved or loaded.
@@ -166,21 +201,35 @@ void Save_LinkGraph(LinkGraph &lg)
 void Load_LinkGraph(LinkGraph &lg)
 {
 	uint size = lg.Size();
+	std::vector<std::pair<Edge, NodeID>> matrix_row;
 	for (NodeID from = 0; from < size; ++from) {
 		Node *node = &lg.nodes[from];
 		SlObjectLoadFiltered(node, _filtered_node_desc);
+		Edge edge;
 		if (IsSavegameVersionBefore(SLV_191)) {
 			/* We used to save the full matrix ... */
+			matrix_row.clear();
 			for (NodeID to = 0; to < size; ++to) {
-				SlObjectLoadFiltered(&lg.edges[from][to], _filtered_edge_desc);
+				edge.Init();
+				SlObjectLoadFiltered(&edge, _filtered_edge_desc);
+				matrix_row.emplace_back(edge, _next_edge);
+			}
+			uint count = 0;
+			for (NodeID to = matrix_row[from].second; to != INVALID_NODE; to = matrix_row[to].second) {
+				if (to >= size || ++count > size) SlErrorCorrupt("Link graph structure overflow");
+				AddLoadedEdge(node, from, to, matrix_row[to].first);
 			}
 		} else {
 			/* ... but as that wasted a lot of space we save a sparse matrix now. */
-			for (NodeID to = from; to != INVALID_NODE; to = lg.edges[from][to].next_edge) {
-				if (to >= size) SlErrorCorrupt("Link graph structure overflow");
-				SlObjectLoadFiltered(&lg.edges[from][to], _filtered_edge_desc);
+			uint count = 0;
+			for (NodeID to = from; to != INVALID_NODE; to = _next_edge) {
+				if (to >= size || ++count > size) SlErrorCorrupt("Link graph structure overflow");
+				edge.Init();
+				SlObjectLoadFiltered(&edge, _filtered_edge_desc);
+				if (count > 1) AddLoadedEdge(node, from, to, edge);
 			}
 		}
+		SortLoadedEdges(node);
 	}
 }
 
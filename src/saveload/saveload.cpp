@@ -85,6 +85,7 @@ uint32 _ttdp_version;         ///< version of TTDP savegame (if applicable)
 SaveLoadVersion _sl_version;  ///< the major savegame version identifier
 byte   _sl_minor_version;     ///< the minor savegame version, DO NOT USE!
 std::string _savegame_format; ///< how to compress savegames
+uint _savegame_compression_threads; ///< number of threads to use for (de)compressing savegames, 0 for one per CPU
 bool _do_autosave;            ///< are we doing an autosave at the moment?
 
 extern bool _sl_is_ext_version;
@@ -2691,6 +2692,17 @@ struct ZlibSaveFilter : SaveFilter {
 
 #endif /* WITH_ZLIB */
 
+/**
+ * Get the number of threads to use for (de)compressing savegames.
+ * Only formats whose library supports it use more than one thread.
+ * @return The number of threads, at least 1.
+ */
+static inline uint GetSavegameCompressionThreads()
+{
+	if (_savegame_compression_threads != 0) return _savegame_compression_threads;
+	return std::max<uint>(1, std::thread::hardware_concurrency());
+}
+
 /********************************************
  ********** START OF LZMA CODE **************
  ********************************************/
@@ -2717,6 +2729,20 @@ struct LZMALoadFilter : LoadFilter {
 	 */
 	LZMALoadFilter(LoadFilter *chain) : LoadFilter(chain), lzma(_lzma_init)
 	{
+#if LZMA_VERSION >= 50040002
+		uint threads = GetSavegameCompressionThreads();
+		if (threads > 1) {
+			/* Streams written by the multi-threaded compressor consist of independent blocks, which are decompressed in parallel.
+			 * Other streams are decompressed in a single thread. */
+			lzma_mt mt = {};
+			mt.threads = threads;
+			mt.memlimit_threading = 1 << 28;
+			mt.memlimit_stop = 1 << 28;
+			if (lzma_stream_decoder_mt(&this->lzma, &mt) == LZMA_OK) return;
+			DEBUG(sl, 1, "Cannot initialize multi-threaded LZMA decompressor, falling back to single-threaded decompression");
+		}
+#endif
+
 		/* Allow saves up to 256 MB uncompressed */
 		if (lzma_auto_decoder(&this->lzma, 1 << 28, 0) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize decompressor");
 	}
@@ -2760,6 +2786,20 @@ struct LZMASaveFilter : SaveFilter {
 	 */
 	LZMASaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), lzma(_lzma_init)
 	{
+#if LZMA_VERSION >= 50020002
+		uint threads = GetSavegameCompressionThreads();
+		if (threads > 1) {
+			/* Split the stream into blocks which are compressed in parallel. This is still a regular xz stream,
+			 * which can be loaded by any version, but compresses slightly worse than a single block. */
+			lzma_mt mt = {};
+			mt.threads = threads;
+			mt.preset = compression_level;
+			mt.check = LZMA_CHECK_CRC32;
+			if (lzma_stream_encoder_mt(&this->lzma, &mt) == LZMA_OK) return;
+			DEBUG(sl, 1, "Cannot initialize multi-threaded LZMA compressor, falling back to single-threaded compression");
+		}
+#endif
+
 		if (lzma_easy_encoder(&this->lzma, compression_level, LZMA_CHECK_CRC32) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
 	}
 
@@ -2879,6 +2919,14 @@ struct ZSTDSaveFilter : SaveFilter {
 			ZSTD_freeCCtx(this->zstd);
 			SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "invalid compresison level");
 		}
+
+		uint threads = GetSavegameCompressionThreads();
+		if (threads > 1) {
+			/* This fails when libzstd is built without multi-threading support, just compress in this thread then. */
+			if (ZSTD_isError(ZSTD_CCtx_setParameter(this->zstd, ZSTD_c_nbWorkers, (int)threads))) {
+				DEBUG(sl, 1, "Cannot use multi-threaded ZSTD compression, falling back to single-threaded compression");
+			}
+		}
 	}
 
 	/** Clean up what we allocated. */
@@ -643,6 +643,7 @@ void SlResetVENC();
 void SlProcessVENC();
 
 extern std::string _savegame_format;
+extern uint _savegame_compression_threads;
 extern bool _do_autosave;
 
 #endif /* SAVELOAD_H */
@@ -27,6 +27,7 @@ typedef LinkGraph::BaseEdge Edge;
 static uint16 _num_nodes;
 static LinkGraph *_linkgraph; ///< Contains the current linkgraph being saved/loaded.
 static NodeID _linkgraph_from; ///< Contains the current "from" node being saved/loaded.
+static NodeID _linkgraph_next_edge; ///< Contains the destination of the next edge of the "from" node being saved/loaded.
 
 class SlLinkgraphEdge : public DefaultSaveLoadHandler<SlLinkgraphEdge, Node> {
 public:
@@ -36,47 +37,83 @@ public:
 		//SLE_CONDVAR(Edge, travel_time_sum,          SLE_UINT64, SLV_LINKGRAPH_TRAVEL_TIME, SL_MAX_VERSION),
 		    SLE_VAR(Edge, last_unrestricted_update, SLE_INT32),
 		SLE_CONDVAR(Edge, last_restricted_update,   SLE_INT32, SLV_187, SL_MAX_VERSION),
-		    SLE_VAR(Edge, next_edge,                SLE_UINT16),
+		   SLEG_VAR("next_edge", _linkgraph_next_edge, SLE_UINT16),
 	};
 	inline const static SaveLoadCompatTable compat_description = _linkgraph_edge_sl_compat;
 
 	void Save(Node *bn) const override
 	{
-		uint16 size = 0;
-		for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph->edges[_linkgraph_from][to].next_edge) {
-			size++;
+		std::vector<Edge> &edges = _linkgraph->nodes[_linkgraph_from].edges;
+
+		/* The edges are saved as a list linked by next_edge, starting at an empty edge from the node to itself. */
+		SlSetStructListLength(edges.size() + 1);
+		Edge head;
+		head.Init(_linkgraph_from);
+		_linkgraph_next_edge = edges.empty() ? INVALID_NODE : edges.front().dest_node;
+		SlObject(&head, this->GetDescription());
+		for (size_t i = 0; i < edges.size(); i++) {
+			_linkgraph_next_edge = (i + 1 < edges.size()) ? edges[i + 1].dest_node : INVALID_NODE;
+			SlObject(&edges[i], this->GetDescription());
 		}
+	}
 
-		SlSetStructListLength(size);
-		for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph->edges[_linkgraph_from][to].next_edge) {
-			SlObject(&_linkgraph->edges[_linkgraph_from][to], this->GetDescription());
-		}
+	/**
+	 * Add a loaded edge to the "from" node, if it is a real link.
+	 * @param to Destination of the edge.
+	 * @param edge Loaded edge.
+	 */
+	static void AddLoadedEdge(NodeID to, Edge edge)
+	{
+		if (to == _linkgraph_from) return;
+		edge.dest_node = to;
+		_linkgraph->nodes[_linkgraph_from].edges.push_back(edge);
 	}
 
 	void Load(Node *bn) const override
 	{
 		uint16 max_size = _linkgraph->Size();
+		std::vector<Edge> &edges = _linkgraph->nodes[_linkgraph_from].edges;
+		Edge edge;
 
 		if (IsSavegameVersionBefore(SLV_191)) {
 			/* We used to save the full matrix ... */
+			std::vector<std::pair<Edge, NodeID>> matrix_row;
 			for (NodeID to = 0; to < max_size; ++to) {
-				SlObject(&_linkgraph->edges[_linkgraph_from][to], this->GetLoadDescription());
+				edge.Init();
+				SlObject(&edge, this->GetLoadDescription());
+				matrix_row.emplace_back(edge, _linkgraph_next_edge);
+			}
+			uint count = 0;
+			for (NodeID to = matrix_row[_linkgraph_from].second; to != INVALID_NODE; to = matrix_row[to].second) {
+				if (to >= max_size || ++count > max_size) SlErrorCorrupt("Link graph structure overflow");
+				AddLoadedEdge(to, matrix_row[to].first);
+			}
+		} else {
+			size_t used_size = IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) ? max_size : SlGetStructListLength(UINT16_MAX);
+
+			/* ... but as that wasted a lot of space we save a sparse matrix now. */
+			bool head = true;
+			for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph_next_edge) {
+				if (used_size == 0) SlErrorCorrupt("Link graph structure overflow");
+				used_size--;
+
+				if (to >= max_size) SlErrorCorrupt("Link graph structure overflow");
+				edge.Init();
+				SlObject(&edge, this->GetLoadDescription());
+				if (!head) AddLoadedEdge(to, edge);
+				head = false;
 			}
-			return;
-		}
-
-		size_t used_size = IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) ? max_size : SlGetStructListLength(UINT16_MAX);
-
-		/* ... but as that wasted a lot of space we save a sparse matrix now. */
-		for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph->edges[_linkgraph_from][to].next_edge) {
-			if (used_size == 0) SlErrorCorrupt("Link graph structure overflow");
-			used_size--;
 
-			if (to >= max_size) SlErrorCorrupt("Link graph structure overflow");
-			SlObject(&_linkgraph->edges[_linkgraph_from][to], this->GetLoadDescription());
+			if (!IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) && used_size > 0) SlErrorCorrupt("Corrupted link graph");
 		}
 
-		if (!IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) && used_size > 0) SlErrorCorrupt("Corrupted link graph");
+		std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+			return a.dest_node < b.dest_node;
+		});
+		auto dup = std::adjacent_find(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+			return a.dest_node == b.dest_node;
+		});
+		if (dup != edges.end()) SlErrorCorrupt("Duplicate link graph edge");
 	}
 };
 
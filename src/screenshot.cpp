@@ -31,9 +31,14 @@
 #include "smallmap_colours.h"
 #include "smallmap_gui.h"
 #include "screenshot_gui.h"
+#include "thread.h"
 
 #include "table/strings.h"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 #include "safeguards.h"
 
 static const char * const SCREENSHOT_NAME = "screenshot"; ///< Default filename of a saved screenshot.
@@ -261,50 +266,140 @@ static void PNGAPI png_my_warning(png_structp png_ptr, png_const_charp message)
 }
 
 /**
- * Generic .PNG file image writer.
+ * Bands of lines of an image, which are rendered on the thread making the screenshot and
+ * passed on to the PNG encoder. When the encoder runs on its own thread, the next band is
+ * rendered while the previous one is being compressed. Only a fixed number of bands is
+ * buffered, so memory use does not depend on the height of the image.
+ */
+class PNGBandQueue {
+	static const uint BUFFERED_BANDS = 2; ///< Number of bands which can be rendered ahead of the encoder.
+
+	ScreenshotCallback *callb; ///< Callback function for generating lines of pixels.
+	void *userdata;            ///< User data, passed on to \a callb.
+	uint w;                    ///< Width of the image in pixels.
+	uint h;                    ///< Height of the image in pixels.
+	uint maxlines;             ///< Number of lines per band.
+	size_t band_size;          ///< Size of each band buffer in bytes.
+	std::unique_ptr<uint8[]> buffers[BUFFERED_BANDS];
+
+	bool threaded = false;     ///< Whether the bands are rendered by Render instead of by GetBand.
+	std::mutex lock;
+	std::condition_variable produced_cond;
+	std::condition_variable consumed_cond;
+	uint produced = 0;         ///< Number of bands rendered.
+	uint consumed = 0;         ///< Number of bands released by the encoder.
+	bool aborted = false;      ///< Whether the encoder has given up.
+
+public:
+	PNGBandQueue(ScreenshotCallback *callb, void *userdata, uint w, uint h, uint bpp) : callb(callb), userdata(userdata), w(w), h(h)
+	{
+		/* use by default 64k temp memory per band */
+		this->maxlines = Clamp(65536 / w, 16, 128);
+		this->band_size = (size_t)w * this->maxlines * bpp;
+		for (auto &buffer : this->buffers) {
+			buffer.reset(new uint8[this->band_size]);
+			memset(buffer.get(), 0, this->band_size);
+		}
+	}
+
+	/** Get the number of bands in the image. */
+	uint GetBandCount() const { return CeilDiv(this->h, this->maxlines); }
+
+	/** Get the number of lines of a band. */
+	uint GetBandLines(uint band) const { return std::min(this->h - band * this->maxlines, this->maxlines); }
+
+	void SetThreaded(bool threaded) { this->threaded = threaded; }
+
+	/**
+	 * Render all bands on the calling thread, while the encoder consumes them on another thread.
+	 * Returns early when the encoder aborts.
+	 */
+	void Render()
+	{
+		for (uint band = 0; band < this->GetBandCount(); band++) {
+			{
+				std::unique_lock<std::mutex> guard(this->lock);
+				this->consumed_cond.wait(guard, [&]() { return this->aborted || band - this->consumed < BUFFERED_BANDS; });
+				if (this->aborted) return;
+			}
+
+			this->callb(this->userdata, this->buffers[band % BUFFERED_BANDS].get(), band * this->maxlines, this->w, this->GetBandLines(band));
+
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->produced++;
+			this->produced_cond.notify_one();
+		}
+	}
+
+	/**
+	 * Get the pixels of a band, rendering them if not threaded.
+	 * @param band Band to get, bands must be requested in order.
+	 * @return Lines of the band.
+	 */
+	const uint8 *GetBand(uint band)
+	{
+		uint8 *buffer = this->buffers[band % BUFFERED_BANDS].get();
+		if (this->threaded) {
+			std::unique_lock<std::mutex> guard(this->lock);
+			this->produced_cond.wait(guard, [&]() { return this->produced > band; });
+		} else {
+			this->callb(this->userdata, buffer, band * this->maxlines, this->w, this->GetBandLines(band));
+		}
+		return buffer;
+	}
+
+	/** Release the oldest band obtained using GetBand, so it can be rendered to again. */
+	void ReleaseBand()
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->consumed++;
+		this->consumed_cond.notify_one();
+	}
+
+	/** Stop rendering, as the encoder has given up. */
+	void Abort()
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->aborted = true;
+		this->consumed_cond.notify_one();
+	}
+};
+
+/**
+ * Compress the lines of an image into a .PNG file.
+ * This may run on a different thread than the one rendering the lines, so it must not access the game state.
+ * @param f           File to write to.
  * @param name        Filename, including extension.
- * @param callb       Callback function for generating lines of pixels.
- * @param userdata    User data, passed on to \a callb.
+ * @param queue       Queue to get the lines of the image from.
  * @param w           Width of the image in pixels.
  * @param h           Height of the image in pixels.
  * @param pixelformat Bits per pixel (bpp), either 8 or 32.
  * @param palette     %Colour palette (for 8bpp images).
+ * @param description Description to add as metadata, or nullptr.
+ * @param description_length Length of \a description.
  * @return File was written successfully.
- * @see ScreenshotHandlerProc
  */
-static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *userdata, uint w, uint h, int pixelformat, const Colour *palette)
+static bool EncodePNGImage(FILE *f, const char *name, PNGBandQueue &queue, uint w, uint h, int pixelformat, const Colour *palette, const char *description, size_t description_length)
 {
 	png_color rq[256];
-	FILE *f;
-	uint i, y, n;
-	uint maxlines;
 	uint bpp = pixelformat / 8;
 	png_structp png_ptr;
 	png_infop info_ptr;
 
-	/* only implemented for 8bit and 32bit images so far. */
-	if (pixelformat != 8 && pixelformat != 32) return false;
-
-	f = fopen(name, "wb");
-	if (f == nullptr) return false;
-
 	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, const_cast<char *>(name), png_my_error, png_my_warning);
 
 	if (png_ptr == nullptr) {
-		fclose(f);
 		return false;
 	}
 
 	info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == nullptr) {
 		png_destroy_write_struct(&png_ptr, (png_infopp)nullptr);
-		fclose(f);
 		return false;
 	}
 
 	if (setjmp(png_jmpbuf(png_ptr))) {
 		png_destroy_write_struct(&png_ptr, &info_ptr);
-		fclose(f);
 		return false;
 	}
 
@@ -324,27 +419,9 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 	text[0].text = const_cast<char *>(_openttd_revision);
 	text[0].text_length = strlen(_openttd_revision);
 	text[0].compression = PNG_TEXT_COMPRESSION_NONE;
-
-	char buf[8192];
-	char *p = buf;
-	p += seprintf(p, lastof(buf), "Graphics set: %s (%u)\n", BaseGraphics::GetUsedSet()->name.c_str(), BaseGraphics::GetUsedSet()->version);
-	p = strecpy(p, "NewGRFs:\n", lastof(buf));
-	for (const GRFConfig *c = _game_mode == GM_MENU ? nullptr : _grfconfig; c != nullptr; c = c->next) {
-		p += seprintf(p, lastof(buf), "%08X ", BSWAP32(c->ident.grfid));
-		p = md5sumToString(p, lastof(buf), c->ident.md5sum);
-		p += seprintf(p, lastof(buf), " %s\n", c->filename);
-	}
-	p = strecpy(p, "\nCompanies:\n", lastof(buf));
-	for (const Company *c : Company::Iterate()) {
-		if (c->ai_info == nullptr) {
-			p += seprintf(p, lastof(buf), "%2i: Human\n", (int)c->index);
-		} else {
-			p += seprintf(p, lastof(buf), "%2i: %s (v%d)\n", (int)c->index, c->ai_info->GetName(), c->ai_info->GetVersion());
-		}
-	}
 	text[1].key = const_cast<char *>("Description");
-	text[1].text = buf;
-	text[1].text_length = p - buf;
+	text[1].text = const_cast<char *>(description);
+	text[1].text_length = description_length;
 	text[1].compression = PNG_TEXT_COMPRESSION_zTXt;
 	if (_screenshot_aux_text_key && _screenshot_aux_text_value) {
 		text[2].key = const_cast<char *>(_screenshot_aux_text_key);
@@ -357,7 +434,7 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 
 	if (pixelformat == 8) {
 		/* convert the palette to the .PNG format. */
-		for (i = 0; i != 256; i++) {
+		for (uint i = 0; i != 256; i++) {
 			rq[i].red   = palette[i].r;
 			rq[i].green = palette[i].g;
 			rq[i].blue  = palette[i].b;
@@ -388,34 +465,91 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 #endif /* TTD_ENDIAN == TTD_LITTLE_ENDIAN */
 	}
 
-	/* use by default 64k temp memory */
-	maxlines = Clamp(65536 / w, 16, 128);
-
 	/* now generate the bitmap bits */
-	void *buff = CallocT<uint8>(w * maxlines * bpp); // by default generate 128 lines at a time.
-
-	y = 0;
-	do {
-		/* determine # lines to write */
-		n = std::min(h - y, maxlines);
-
-		/* render the pixels into the buffer */
-		callb(userdata, buff, y, w, n);
-		y += n;
+	for (uint band = 0; band < queue.GetBandCount(); band++) {
+		const uint8 *buff = queue.GetBand(band);
 
 		/* write them to png */
-		for (i = 0; i != n; i++) {
-			png_write_row(png_ptr, (png_bytep)buff + i * w * bpp);
+		const uint n = queue.GetBandLines(band);
+		for (uint i = 0; i != n; i++) {
+			png_write_row(png_ptr, buff + i * w * bpp);
 		}
-	} while (y != h);
+
+		queue.ReleaseBand();
+	}
 
 	png_write_end(png_ptr, info_ptr);
 	png_destroy_write_struct(&png_ptr, &info_ptr);
 
-	free(buff);
-	fclose(f);
 	return true;
 }
+
+/**
+ * Generic .PNG file image writer.
+ * When possible, the image is compressed on a separate thread while the lines are being rendered.
+ * @param name        Filename, including extension.
+ * @param callb       Callback function for generating lines of pixels.
+ * @param userdata    User data, passed on to \a callb.
+ * @param w           Width of the image in pixels.
+ * @param h           Height of the image in pixels.
+ * @param pixelformat Bits per pixel (bpp), either 8 or 32.
+ * @param palette     %Colour palette (for 8bpp images).
+ * @return File was written successfully.
+ * @see ScreenshotHandlerProc
+ */
+static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *userdata, uint w, uint h, int pixelformat, const Colour *palette)
+{
+	/* only implemented for 8bit and 32bit images so far. */
+	if (pixelformat != 8 && pixelformat != 32) return false;
+
+	FILE *f = fopen(name, "wb");
+	if (f == nullptr) return false;
+
+	char buf[8192];
+	char *p = buf;
+#ifdef PNG_TEXT_SUPPORTED
+	/* The metadata is collected here, as the encoder may not access the game state. */
+	p += seprintf(p, lastof(buf), "Graphics set: %s (%u)\n", BaseGraphics::GetUsedSet()->name.c_str(), BaseGraphics::GetUsedSet()->version);
+	p = strecpy(p, "NewGRFs:\n", lastof(buf));
+	for (const GRFConfig *c = _game_mode == GM_MENU ? nullptr : _grfconfig; c != nullptr; c = c->next) {
+		p += seprintf(p, lastof(buf), "%08X ", BSWAP32(c->ident.grfid));
+		p = md5sumToString(p, lastof(buf), c->ident.md5sum);
+		p += seprintf(p, lastof(buf), " %s\n", c->filename);
+	}
+	p = strecpy(p, "\nCompanies:\n", lastof(buf));
+	for (const Company *c : Company::Iterate()) {
+		if (c->ai_info == nullptr) {
+			p += seprintf(p, lastof(buf), "%2i: Human\n", (int)c->index);
+		} else {
+			p += seprintf(p, lastof(buf), "%2i: %s (v%d)\n", (int)c->index, c->ai_info->GetName(), c->ai_info->GetVersion());
+		}
+	}
+#endif /* PNG_TEXT_SUPPORTED */
+
+	PNGBandQueue queue(callb, userdata, w, h, pixelformat / 8);
+	bool ret = false;
+
+	std::thread encoder;
+	bool threaded = false;
+	if (queue.GetBandCount() > 1 && std::thread::hardware_concurrency() > 1) {
+		/* The lines are rendered on this thread, as rendering is not thread safe. */
+		queue.SetThreaded(true);
+		threaded = StartNewThread(&encoder, "ottd:png", [&]() {
+			ret = EncodePNGImage(f, name, queue, w, h, pixelformat, palette, buf, p - buf);
+			if (!ret) queue.Abort();
+		});
+		if (threaded) {
+			queue.Render();
+			encoder.join();
+		} else {
+			queue.SetThreaded(false);
+		}
+	}
+	if (!threaded) ret = EncodePNGImage(f, name, queue, w, h, pixelformat, palette, buf, p - buf);
+
+	fclose(f);
+	return ret;
+}
 #endif /* WITH_PNG */
 
 
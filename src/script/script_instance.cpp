@@ -757,6 +757,12 @@ size_t ScriptInstance::GetAllocatedMemory() const
 	return this->engine->GetAllocatedMemory();
 }
 
+ScriptAllocatorStats ScriptInstance::GetAllocatorStats() const
+{
+	if (this->engine == nullptr) return { this->last_allocated_memory, 0, 0, 0 };
+	return this->engine->GetAllocatorStats();
+}
+
 void ScriptInstance::SetMemoryAllocationLimit(size_t limit) const
 {
 	if (this->engine != nullptr) this->engine->SetMemoryAllocationLimit(limit);
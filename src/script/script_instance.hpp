@@ -19,6 +19,8 @@
 
 static const uint SQUIRREL_MAX_DEPTH = 25; ///< The maximum recursive depth for items stored in the savegame.
 
+struct ScriptAllocatorStats;
+
 /** Runtime information about a script like a pointer to the squirrel vm and the current state. */
 class ScriptInstance {
 public:
@@ -203,6 +205,8 @@ public:
 
 	size_t GetAllocatedMemory() const;
 
+	ScriptAllocatorStats GetAllocatorStats() const;
+
 	void SetMemoryAllocationLimit(size_t limit) const;
 
 	/**
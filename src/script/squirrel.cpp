@@ -20,7 +20,9 @@
 #include "../core/alloc_func.hpp"
 
 #include <stdarg.h>
+#include <array>
 #include <map>
+#include <vector>
 
 /**
  * In the memory allocator for Squirrel we want to directly use malloc/realloc, so when the OS
@@ -49,6 +51,24 @@ struct ScriptAllocator {
 
 	static const size_t SAFE_LIMIT = 0x8000000; ///< 128 MiB, a safe choice for almost any situation
 
+	/*
+	 * Small allocations, which make up the bulk of what Squirrel allocates, are served from
+	 * per size class free lists which are carved out of large slabs. As Squirrel passes the
+	 * size of the block when freeing it no per block header is needed, and all slabs can be
+	 * released at once when the VM is torn down.
+	 */
+	static const size_t SLAB_GRANULARITY = 16;      ///< Size step between the size classes, also the alignment of the blocks
+	static const size_t SLAB_MAX_BLOCK_SIZE = 256;  ///< Largest allocation served from the slabs
+	static const size_t SLAB_SIZE = 64 * 1024;      ///< Size of each slab
+	static const uint SLAB_SIZE_CLASSES = SLAB_MAX_BLOCK_SIZE / SLAB_GRANULARITY;
+
+	std::array<void *, SLAB_SIZE_CLASSES> free_blocks; ///< Free list heads per size class
+	std::vector<byte *> slabs;                        ///< All slabs owned by this allocator
+	byte *slab_next;                                  ///< Next unused block in the current slab
+	size_t slab_free_size;                            ///< Unused size at the end of the current slab
+	uint64 small_allocations;                         ///< Number of allocations served from the slabs
+	uint64 large_allocations;                         ///< Number of allocations passed on to malloc
+
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 	std::map<void *, size_t> allocations;
 #endif
@@ -59,15 +79,13 @@ struct ScriptAllocator {
 	}
 
 	/**
-	 * Catch all validation for the allocation; did it allocate too much memory according
-	 * to the allocation limit or did the allocation at the OS level maybe fail? In those
-	 * error situations a Script_FatalError is thrown, but once that has been done further
-	 * allocations are allowed to make it possible for Squirrel to throw the error and
-	 * clean everything up.
+	 * Check whether an allocation of the given size would exceed the allocation limit,
+	 * and if so throw a Script_FatalError. Once that has been done further allocations
+	 * are allowed to make it possible for Squirrel to throw the error and clean
+	 * everything up.
 	 * @param requested_size The requested size that was requested to be allocated.
-	 * @param p              The pointer to the allocated object, or null if allocation failed.
 	 */
-	void CheckAllocation(size_t requested_size, void *p)
+	void CheckAllocationLimit(size_t requested_size)
 	{
 		if (this->allocated_size + requested_size > this->allocation_limit && !this->error_thrown) {
 			/* Do not allow allocating more than the allocation limit, except when an error is
@@ -77,11 +95,18 @@ struct ScriptAllocator {
 			char buff[128];
 			seprintf(buff, lastof(buff), "Maximum memory allocation exceeded by " PRINTF_SIZE " bytes when allocating " PRINTF_SIZE " bytes",
 				this->allocated_size + requested_size - this->allocation_limit, requested_size);
-			/* Don't leak the rejected allocation. */
-			free(p);
 			throw Script_FatalError(buff);
 		}
+	}
 
+	/**
+	 * Check whether the allocation at the OS level failed. In that case a Script_FatalError
+	 * is thrown, unless we are already handling an allocation error.
+	 * @param requested_size The requested size that was requested to be allocated.
+	 * @param p              The pointer to the allocated object, or null if allocation failed.
+	 */
+	void CheckAllocationResult(size_t requested_size, void *p)
+	{
 		if (p == nullptr) {
 			/* The OS did not have enough memory to allocate the object, regardless of the
 			 * limit imposed by OpenTTD on the amount of memory that may be allocated. */
@@ -99,11 +124,88 @@ struct ScriptAllocator {
 		}
 	}
 
+	/**
+	 * Get the size class for a small allocation.
+	 * @param size The size of the allocation, at most SLAB_MAX_BLOCK_SIZE.
+	 * @return The index of the size class.
+	 */
+	static inline uint GetSizeClass(size_t size)
+	{
+		return size == 0 ? 0 : (uint)((size - 1) / SLAB_GRANULARITY);
+	}
+
+	/**
+	 * Allocate a block of memory, small blocks are taken from the slabs.
+	 * @param size The size of the block.
+	 * @return The block, or nullptr if the allocation at the OS level failed.
+	 */
+	void *AllocateBlock(size_t size)
+	{
+		if (size > SLAB_MAX_BLOCK_SIZE) {
+			this->large_allocations++;
+			return malloc(size);
+		}
+
+		const uint size_class = GetSizeClass(size);
+		void *p = this->free_blocks[size_class];
+		if (p != nullptr) {
+			this->free_blocks[size_class] = *static_cast<void **>(p);
+		} else {
+			const size_t block_size = (size_class + 1) * SLAB_GRANULARITY;
+			if (this->slab_free_size < block_size) {
+				/* The remainder of the current slab is too small, it is simply left unused. */
+				byte *slab = static_cast<byte *>(malloc(SLAB_SIZE));
+				if (slab == nullptr) return nullptr;
+				this->slabs.push_back(slab);
+				this->slab_next = slab;
+				this->slab_free_size = SLAB_SIZE;
+			}
+			p = this->slab_next;
+			this->slab_next += block_size;
+			this->slab_free_size -= block_size;
+		}
+		this->small_allocations++;
+		return p;
+	}
+
+	/**
+	 * Free a block of memory allocated by AllocateBlock.
+	 * @param p The block.
+	 * @param size The size of the block, as passed to AllocateBlock.
+	 */
+	void FreeBlock(void *p, size_t size)
+	{
+		if (size > SLAB_MAX_BLOCK_SIZE) {
+			free(p);
+			return;
+		}
+
+		const uint size_class = GetSizeClass(size);
+		*static_cast<void **>(p) = this->free_blocks[size_class];
+		this->free_blocks[size_class] = p;
+	}
+
+	/**
+	 * Release all slabs at once, this invalidates all small blocks still allocated.
+	 */
+	void ReleaseSlabs()
+	{
+		for (byte *slab : this->slabs) {
+			free(slab);
+		}
+		this->slabs.clear();
+		this->free_blocks.fill(nullptr);
+		this->slab_next = nullptr;
+		this->slab_free_size = 0;
+	}
+
 	void *Malloc(SQUnsignedInteger size)
 	{
-		void *p = malloc(size);
+		this->CheckAllocationLimit(size);
 
-		this->CheckAllocation(size, p);
+		void *p = this->AllocateBlock(size);
+
+		this->CheckAllocationResult(size, p);
 
 		this->allocated_size += size;
 
@@ -126,28 +228,35 @@ struct ScriptAllocator {
 			return nullptr;
 		}
 
+		if (size > oldsize) this->CheckAllocationLimit(size - oldsize);
+
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(this->allocations[p] == oldsize);
 		this->allocations.erase(p);
 #endif
-		/* Can't use realloc directly because memory limit check.
-		 * If memory exception is thrown, the old pointer is expected
-		 * to be valid for engine cleanup.
-		 */
-		void *new_p = malloc(size);
 
-		this->CheckAllocation(size - oldsize, new_p);
+		void *new_p;
+		if (oldsize <= SLAB_MAX_BLOCK_SIZE && size <= SLAB_MAX_BLOCK_SIZE && GetSizeClass(oldsize) == GetSizeClass(size)) {
+			/* The block is large enough already. */
+			new_p = p;
+		} else {
+			/* Can't use realloc directly as the old pointer is expected
+			 * to be valid for engine cleanup if the allocation fails.
+			 */
+			new_p = this->AllocateBlock(size);
 
-		/* Memory limit test passed, we can copy data and free old pointer. */
-		memcpy(new_p, p, std::min(oldsize, size));
-		free(p);
+			this->CheckAllocationResult(size, new_p);
+
+			memcpy(new_p, p, std::min(oldsize, size));
+			this->FreeBlock(p, oldsize);
+		}
 
 		this->allocated_size -= oldsize;
 		this->allocated_size += size;
 
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(new_p != nullptr);
-		assert(this->allocations.find(p) == this->allocations.end());
+		assert(this->allocations.find(new_p) == this->allocations.end());
 		this->allocations[new_p] = size;
 #endif
 
@@ -157,7 +266,7 @@ struct ScriptAllocator {
 	void Free(void *p, SQUnsignedInteger size)
 	{
 		if (p == nullptr) return;
-		free(p);
+		this->FreeBlock(p, size);
 		this->allocated_size -= size;
 
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
@@ -166,12 +275,27 @@ struct ScriptAllocator {
 #endif
 	}
 
+	ScriptAllocatorStats GetStats() const
+	{
+		ScriptAllocatorStats stats;
+		stats.allocated_size = this->allocated_size;
+		stats.slab_reserved = this->slabs.size() * SLAB_SIZE;
+		stats.small_allocations = this->small_allocations;
+		stats.large_allocations = this->large_allocations;
+		return stats;
+	}
+
 	ScriptAllocator()
 	{
 		this->allocated_size = 0;
 		this->allocation_limit = static_cast<size_t>(_settings_game.script.script_max_memory_megabytes) << 20;
 		if (this->allocation_limit == 0) this->allocation_limit = SAFE_LIMIT; // in case the setting is somehow zero
 		this->error_thrown = false;
+		this->free_blocks.fill(nullptr);
+		this->slab_next = nullptr;
+		this->slab_free_size = 0;
+		this->small_allocations = 0;
+		this->large_allocations = 0;
 	}
 
 	~ScriptAllocator()
@@ -179,6 +303,7 @@ struct ScriptAllocator {
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(this->allocations.size() == 0);
 #endif
+		this->ReleaseSlabs();
 	}
 };
 
@@ -205,6 +330,12 @@ size_t Squirrel::GetAllocatedMemory() const noexcept
 	return this->allocator->allocated_size;
 }
 
+ScriptAllocatorStats Squirrel::GetAllocatorStats() const noexcept
+{
+	assert(this->allocator != nullptr);
+	return this->allocator->GetStats();
+}
+
 void Squirrel::SetMemoryAllocationLimit(size_t limit) noexcept
 {
 	if (this->allocator != nullptr) {
@@ -777,6 +908,9 @@ void Squirrel::Uninitialize()
 
 	assert(this->allocator->allocated_size == 0);
 
+	/* Everything has been freed, return the slabs to the system. */
+	this->allocator->ReleaseSlabs();
+
 	/* Reset memory allocation errors. */
 	this->allocator->error_thrown = false;
 }
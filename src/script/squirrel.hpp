@@ -20,6 +20,14 @@ enum ScriptType {
 
 struct ScriptAllocator;
 
+/** Statistics of the memory allocator of a script. */
+struct ScriptAllocatorStats {
+	size_t allocated_size;    ///< Sum of allocated data size
+	size_t slab_reserved;     ///< Memory reserved for the slabs used for small allocations
+	uint64 small_allocations; ///< Number of allocations served from the slabs
+	uint64 large_allocations; ///< Number of allocations passed on to malloc
+};
+
 class Squirrel {
 	friend class ScriptAllocatorScope;
 
@@ -281,6 +289,11 @@ public:
 	 */
 	size_t GetAllocatedMemory() const noexcept;
 
+	/**
+	 * Get the statistics of the memory allocator of this VM.
+	 */
+	ScriptAllocatorStats GetAllocatorStats() const noexcept;
+
 	void SetMemoryAllocationLimit(size_t limit) noexcept;
 };
 
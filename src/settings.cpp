@@ -914,6 +914,7 @@ static void RedrawSmallmap(int32 new_value)
 {
 	BuildLandLegend();
 	BuildOwnerLegend();
+	InvalidateSmallMapColours();
 	SetWindowClassesDirty(WC_SMALLMAP);
 
 	extern void MarkAllViewportMapLandscapesDirty();
@@ -23,6 +23,7 @@
 #include "tunnelbridge.h"
 #include "bridge_signal_map.h"
 #include "newgrf_newsignals.h"
+#include "3rdparty/cpp-btree/btree_map.h"
 
 #include "safeguards.h"
 
@@ -42,10 +43,7 @@ static void MarkDependencidesForUpdate(SignalReference sig);
 /** these are the maximums used for updating signal blocks */
 static const uint SIG_TBU_SIZE    =  64; ///< number of signals entering to block
 static const uint SIG_TBD_SIZE    = 256; ///< number of intersections - open nodes in current block
-static const uint SIG_GLOB_SIZE   = 128; ///< number of open blocks (block can be opened more times until detected)
-static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _globset to force update
-
-static_assert(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
+static const uint SIG_GLOB_UPDATE =  64; ///< number of blocks updated from _globset before the count of evaluated signals is reset
 
 /** incidating trackbits with given enterdir */
 static const TrackBits _enterdir_to_trackbits[DIAGDIR_END] = {
@@ -202,10 +200,110 @@ public:
 	}
 };
 
+/**
+ * Set of places (tile and side) of which the signal blocks have to be updated.
+ * Contrary to SmallSet it is not limited in size, so all changes of a whole command
+ * can be collected and each signal block is explored only once.
+ * Removing an item only decreases its count in the lookup table, the stale stack entry
+ * is skipped when it is reached. As exploring a block removes all its places from the set,
+ * blocks which were already updated are not explored again.
+ */
+struct SignalUpdateSet {
+private:
+	/** Element of set */
+	struct SSdata {
+		TileIndex tile;
+		DiagDirection dir;
+	};
+
+	std::vector<SSdata> stack;             ///< places in the order they were added, including removed ones
+	btree::btree_map<uint64, uint> counts; ///< number of times each place is in the set
+	uint n = 0;                            ///< actual number of units
+
+	static inline uint64 Key(TileIndex tile, DiagDirection dir)
+	{
+		return (((uint64)tile) << 8) | (uint8)dir;
+	}
+
+public:
+	/** Reset variables to default values */
+	void Reset()
+	{
+		this->stack.clear();
+		this->counts.clear();
+		this->n = 0;
+	}
+
+	/**
+	 * Checks for empty set
+	 * @return is the set empty?
+	 */
+	bool IsEmpty() const
+	{
+		return this->n == 0;
+	}
+
+	/**
+	 * Reads the number of items
+	 * @return current number of items
+	 */
+	uint Items() const
+	{
+		return this->n;
+	}
+
+	/**
+	 * Tries to remove one instance of given tile and dir
+	 * @param tile tile
+	 * @param dir and dir to remove
+	 * @return element was found and removed
+	 */
+	bool Remove(TileIndex tile, DiagDirection dir)
+	{
+		auto it = this->counts.find(Key(tile, dir));
+		if (it == this->counts.end()) return false;
+		if (--it->second == 0) this->counts.erase(it);
+		this->n--;
+		return true;
+	}
+
+	/**
+	 * Adds tile & dir into the set
+	 * @param tile tile
+	 * @param dir and dir to add
+	 */
+	void Add(TileIndex tile, DiagDirection dir)
+	{
+		this->stack.push_back({ tile, dir });
+		this->counts[Key(tile, dir)]++;
+		this->n++;
+	}
+
+	/**
+	 * Reads the last added element into the set
+	 * @param tile pointer where tile is written to
+	 * @param dir pointer where dir is written to
+	 * @return false iff the set was empty
+	 */
+	bool Get(TileIndex *tile, DiagDirection *dir)
+	{
+		while (!this->stack.empty()) {
+			SSdata item = this->stack.back();
+			this->stack.pop_back();
+			if (this->Remove(item.tile, item.dir)) {
+				*tile = item.tile;
+				*dir = item.dir;
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
 static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset("_tbuset");         ///< set of signals that will be updated
 static SmallSet<Trackdir, SIG_TBU_SIZE> _tbpset("_tbpset");         ///< set of PBS signals to update the aspect of
 static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of open nodes in current signal block
-static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
+static SignalUpdateSet _globset;                                    ///< set of places to be updated in following runs
 
 static uint _num_signals_evaluated; ///< Number of programmable pre-signals evaluated
 
@@ -840,7 +938,7 @@ static void UpdateSignalsAroundSegment(SigInfo info)
 			if (IsExitSignal(sig)) {
 				/* for pre-signal exits, add block to the global set */
 				DiagDirection exitdir = TrackdirToExitdir(ReverseTrackdir(trackdir));
-				_globset.Add(tile, exitdir); // do not check for full global set, first update all signals
+				_globset.Add(tile, exitdir);
 
 				// Progsig dependencies
 				MarkDependencidesForUpdate(SignalReference(tile, track));
@@ -875,13 +973,12 @@ static void UpdateSignalsAroundSegment(SigInfo info)
 }
 
 
-/** Reset all sets after one set overflowed */
-static inline void ResetSets()
+/** Reset the sets of the current block after one set overflowed */
+static inline void ResetBlockSets()
 {
 	_tbuset.Reset();
 	_tbpset.Reset();
 	_tbdset.Reset();
-	_globset.Reset();
 }
 
 
@@ -899,6 +996,7 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 	bool first = true;  // first block?
 	SigSegState state = SIGSEG_FREE; // value to return
 	_num_signals_evaluated = 0;
+	uint batch_blocks = 0; // number of blocks updated since _num_signals_evaluated was reset
 
 	TileIndex tile = INVALID_TILE; // Stop GCC from complaining about a possibly uninitialized variable (issue #8280).
 	DiagDirection dir = INVALID_DIAGDIR;
@@ -977,10 +1075,10 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 			}
 		}
 
-		/* do not do anything when some buffer was full */
+		/* do not do anything with this block when some buffer was full, but continue with the other places */
 		if (info.flags & SF_FULL) {
-			ResetSets(); // free all sets
-			break;
+			ResetBlockSets(); // free the sets of this block
+			continue;
 		}
 
 		if (_num_signals_evaluated > _settings_game.construction.maximum_signal_evaluations) {
@@ -988,6 +1086,12 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		}
 
 		UpdateSignalsAroundSegment(info);
+
+		/* limit the evaluated signals per batch of blocks, not per whole buffer */
+		if (++batch_blocks == SIG_GLOB_UPDATE) {
+			batch_blocks = 0;
+			_num_signals_evaluated = 0;
+		}
 	}
 
 	if (_settings_game.vehicle.train_braking_model == TBM_REALISTIC) state = SIGSEG_PBS;
@@ -1053,12 +1157,6 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 	};
 	add_dir(_search_dir_1[track]);
 	add_dir(_search_dir_2[track]);
-
-	if (_globset.Items() >= SIG_GLOB_UPDATE) {
-		/* too many items, force update */
-		UpdateSignalsInBuffer(_last_owner);
-		_last_owner = INVALID_OWNER;
-	}
 }
 
 
@@ -1078,12 +1176,6 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 	_last_owner = owner;
 
 	_globset.Add(tile, side);
-
-	if (_globset.Items() >= SIG_GLOB_UPDATE) {
-		/* too many items, force update */
-		UpdateSignalsInBuffer(_last_owner);
-		_last_owner = INVALID_OWNER;
-	}
 }
 
 /**
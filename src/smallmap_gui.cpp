@@ -499,6 +499,127 @@ static void NotifyAllViewports(ViewportMapType map_type)
 	}
 }
 
+/**
+ * Cache of the colours of the cells drawn by #SmallMapWindow::DrawSmallMapColumn, so a refresh of the smallmap
+ * only has to recompute the colours of tiles which changed since the previous refresh.
+ * The cells of a drawing all have the same size and alignment; the cache covers an area of cells around the
+ * visible part of the map, and is rebuilt when the display moves out of it or the zoom level or map type changes.
+ */
+struct SmallMapColourCache {
+	static constexpr uint32 INVALID_COLOUR = 0xD7D7D7D7; ///< Colour value marking a cell which has to be recomputed.
+	static constexpr uint MAX_CELLS = 1 << 22;           ///< Maximum number of cells to cache, larger drawings (screenshots) are not cached.
+
+	int zoom = 0;                ///< Size of the cells in tiles, 0 if the cache is empty.
+	int map_type = -1;           ///< Map type the colours are for.
+	int align_x = 0;             ///< Horizontal tile coordinate of the cells, modulo #zoom.
+	int align_y = 0;             ///< Vertical tile coordinate of the cells, modulo #zoom.
+	int origin_x = 0;            ///< Horizontal cell coordinate of the first cached cell.
+	int origin_y = 0;            ///< Vertical cell coordinate of the first cached cell.
+	uint width = 0;              ///< Number of cached cells in horizontal direction.
+	uint height = 0;             ///< Number of cached cells in vertical direction.
+	bool active = false;         ///< Whether the current drawing uses the cache.
+	std::vector<uint32> colours; ///< Colours of the cells.
+
+	void Clear()
+	{
+		this->zoom = 0;
+		this->colours.clear();
+	}
+
+	/**
+	 * Prepare the cache for a drawing.
+	 * @param zoom Size of the cells in tiles.
+	 * @param map_type Map type being drawn.
+	 * @param tile_x Horizontal tile coordinate of any cell of the drawing.
+	 * @param tile_y Vertical tile coordinate of any cell of the drawing.
+	 * @param min_x Lowest horizontal tile coordinate of the drawing.
+	 * @param min_y Lowest vertical tile coordinate of the drawing.
+	 * @param max_x Highest horizontal tile coordinate of the drawing.
+	 * @param max_y Highest vertical tile coordinate of the drawing.
+	 */
+	void Prepare(int zoom, int map_type, int tile_x, int tile_y, int min_x, int min_y, int max_x, int max_y)
+	{
+		const int align_x = ((tile_x % zoom) + zoom) % zoom;
+		const int align_y = ((tile_y % zoom) + zoom) % zoom;
+		const int cell_min_x = DivTowardsNegativeInf(min_x - align_x, zoom);
+		const int cell_min_y = DivTowardsNegativeInf(min_y - align_y, zoom);
+		const int cell_max_x = DivTowardsNegativeInf(max_x - align_x, zoom);
+		const int cell_max_y = DivTowardsNegativeInf(max_y - align_y, zoom);
+
+		if (this->zoom == zoom && this->map_type == map_type && this->align_x == align_x && this->align_y == align_y &&
+				cell_min_x >= this->origin_x && cell_max_x < this->origin_x + (int)this->width &&
+				cell_min_y >= this->origin_y && cell_max_y < this->origin_y + (int)this->height) {
+			this->active = true;
+			return;
+		}
+
+		/* Cache some cells around the drawing as well, so small scroll movements can reuse the cache. */
+		const int margin_x = (cell_max_x - cell_min_x + 1) / 4;
+		const int margin_y = (cell_max_y - cell_min_y + 1) / 4;
+		const uint width = cell_max_x - cell_min_x + 1 + 2 * margin_x;
+		const uint height = cell_max_y - cell_min_y + 1 + 2 * margin_y;
+		if ((uint64)width * height > MAX_CELLS) {
+			this->active = false;
+			return;
+		}
+
+		this->zoom = zoom;
+		this->map_type = map_type;
+		this->align_x = align_x;
+		this->align_y = align_y;
+		this->origin_x = cell_min_x - margin_x;
+		this->origin_y = cell_min_y - margin_y;
+		this->width = width;
+		this->height = height;
+		this->colours.assign(width * height, INVALID_COLOUR);
+		this->active = true;
+	}
+
+	/**
+	 * Get the cached colour of a cell.
+	 * @param xc Horizontal tile coordinate of the cell.
+	 * @param yc Vertical tile coordinate of the cell.
+	 * @return Pointer to the cached colour, or nullptr if the cell is not cached.
+	 */
+	inline uint32 *GetCell(int xc, int yc)
+	{
+		const uint x = DivTowardsNegativeInf(xc - this->align_x, this->zoom) - this->origin_x;
+		const uint y = DivTowardsNegativeInf(yc - this->align_y, this->zoom) - this->origin_y;
+		if (x >= this->width || y >= this->height) return nullptr;
+		return &this->colours[x + y * this->width];
+	}
+
+	/**
+	 * Mark the cell containing a tile for recomputing.
+	 * @param tile Tile which changed.
+	 */
+	void InvalidateTile(TileIndex tile)
+	{
+		if (this->zoom == 0) return;
+		uint32 *cell = this->GetCell(TileX(tile), TileY(tile));
+		if (cell != nullptr) *cell = INVALID_COLOUR;
+	}
+};
+
+static SmallMapColourCache _smallmap_colour_cache;
+
+/**
+ * Recompute the colours of all tiles in the smallmap on the next refresh.
+ */
+void InvalidateSmallMapColours()
+{
+	_smallmap_colour_cache.Clear();
+}
+
+/**
+ * Recompute the colour of a tile in the smallmap on the next refresh.
+ * @param tile Tile which changed.
+ */
+void InvalidateSmallMapTileColour(TileIndex tile)
+{
+	_smallmap_colour_cache.InvalidateTile(tile);
+}
+
 /** Vehicle colours in #SMT_VEHICLES mode. Indexed by #VehicleType. */
 static const byte _vehicle_type_colours[6] = {
 	PC_RED, PC_YELLOW, PC_LIGHT_BLUE, PC_WHITE, PC_BLACK, PC_RED
@@ -769,7 +890,14 @@ void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch,
 		}
 		ta.ClampToMap(); // Clamp to map boundaries (may contain MP_VOID tiles!).
 
-		uint32 val = this->GetTileColours(ta);
+		uint32 val;
+		uint32 *cached = _smallmap_colour_cache.active ? _smallmap_colour_cache.GetCell(xc, yc) : nullptr;
+		if (cached != nullptr && *cached != SmallMapColourCache::INVALID_COLOUR) {
+			val = *cached;
+		} else {
+			val = this->GetTileColours(ta);
+			if (cached != nullptr) *cached = val;
+		}
 		uint8 *val8 = (uint8 *)&val;
 		int idx = std::max(0, -start_pos);
 		for (int pos = std::max(0, start_pos); pos < end_pos; pos++) {
@@ -895,6 +1023,23 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi, bool draw_indicators) cons
 	int tile_x = this->scroll_x / (int)TILE_SIZE + tile.x;
 	int tile_y = this->scroll_y / (int)TILE_SIZE + tile.y;
 
+	/* Find the range of tiles covered by the drawing, to prepare the colour cache for it. */
+	int min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
+	for (int py : { dpi->top, dpi->top + dpi->height }) {
+		for (int px : { dpi->left, dpi->left + dpi->width }) {
+			int sub;
+			Point corner = this->PixelToTile(px, py, &sub);
+			min_x = std::min(min_x, corner.x);
+			min_y = std::min(min_y, corner.y);
+			max_x = std::max(max_x, corner.x);
+			max_y = std::max(max_y, corner.y);
+		}
+	}
+	const int margin = 2 * this->zoom;
+	_smallmap_colour_cache.Prepare(this->zoom, this->map_type, tile_x, tile_y,
+			this->scroll_x / (int)TILE_SIZE + min_x - margin, this->scroll_y / (int)TILE_SIZE + min_y - margin,
+			this->scroll_x / (int)TILE_SIZE + max_x + margin, this->scroll_y / (int)TILE_SIZE + max_y + margin);
+
 	void *ptr = blitter->MoveTo(dpi->dst_ptr, -dx - 4, 0);
 	int x = - dx - 4;
 	int y = 0;
@@ -923,6 +1068,7 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi, bool draw_indicators) cons
 		ptr = blitter->MoveTo(ptr, 2, 0);
 		x += 2;
 	}
+	_smallmap_colour_cache.active = false;
 
 	/* Draw vehicles */
 	if (this->map_type == SMT_CONTOUR || this->map_type == SMT_VEHICLES) this->DrawVehicles(dpi, blitter);
@@ -1009,6 +1155,7 @@ SmallMapWindow::~SmallMapWindow()
 {
 	delete this->overlay;
 	this->BreakIndustryChainLink();
+	InvalidateSmallMapColours();
 }
 
 /**
@@ -1034,6 +1181,7 @@ void SmallMapWindow::RebuildColourIndexIfNecessary()
 
 	SmallMapWindow::map_height_limit = _settings_game.construction.map_height_limit;
 	BuildLandLegend();
+	InvalidateSmallMapColours();
 }
 
 /* virtual */ void SmallMapWindow::SetStringParameters(int widget) const
@@ -1327,6 +1475,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 		_smallmap_industry_highlight = new_highlight;
 		this->refresh.SetInterval(this->GetRefreshPeriod());
 		_smallmap_industry_highlight_state = true;
+		InvalidateSmallMapColours();
 		this->SetDirty();
 	}
 }
@@ -1404,6 +1553,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 						NotifyAllViewports(VPMT_OWNER);
 					}
 				}
+				InvalidateSmallMapColours();
 				this->SetDirty();
 			}
 			break;
@@ -1431,6 +1581,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 				tbl->show_on_map = (widget == WID_SM_ENABLE_ALL);
 			}
 			if (this->map_type == SMT_LINKSTATS) this->SetOverlayCargoMask();
+			InvalidateSmallMapColours();
 			this->SetDirty();
 			break;
 		}
@@ -1439,6 +1590,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 			_smallmap_show_heightmap = !_smallmap_show_heightmap;
 			this->SetWidgetLoweredState(WID_SM_SHOW_HEIGHT, _smallmap_show_heightmap);
 			NotifyAllViewports(VPMT_INDUSTRY);
+			InvalidateSmallMapColours();
 			this->SetDirty();
 			break;
 
@@ -1482,6 +1634,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 
 		default: NOT_REACHED();
 	}
+	InvalidateSmallMapColours();
 	this->SetDirty();
 }
 
@@ -1522,6 +1675,8 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 		}
 	}
 	_smallmap_industry_highlight_state = !_smallmap_industry_highlight_state;
+	/* The highlighted industries blink. */
+	if (_smallmap_industry_highlight != INVALID_INDUSTRYTYPE) InvalidateSmallMapColours();
 
 	this->refresh.SetInterval(this->GetRefreshPeriod());
 	this->SetDirty();
@@ -50,6 +50,8 @@ void BuildIndustriesLegend();
 void ShowSmallMap();
 void BuildLandLegend();
 void BuildOwnerLegend();
+void InvalidateSmallMapColours();
+void InvalidateSmallMapTileColour(TileIndex tile);
 
 /** Structure for holding relevant data for legends in small map */
 struct LegendAndColour {
@@ -20,6 +20,7 @@
 #include "core/mem_func.hpp"
 #include "video/video_driver.hpp"
 #include "scope_info.h"
+#include "newgrf_config.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -29,6 +30,8 @@
 
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <map>
 
 #include "safeguards.h"
 
@@ -592,7 +595,45 @@ struct GrfSpriteOffset {
 };
 
 /** Map from sprite numbers to position in the GRF file. */
-static btree::btree_map<uint32, GrfSpriteOffset> _grf_sprite_offsets;
+typedef btree::btree_map<uint32, GrfSpriteOffset> GrfSpriteOffsetMap;
+
+/** Sprite offsets of the current GRF, if it isn't in the cache. */
+static GrfSpriteOffsetMap _grf_sprite_offsets_uncached;
+
+/**
+ * Sprite offsets of GRFs by MD5 sum. The sprite section is needed in several
+ * loading stages and on every load of the NewGRFs, and scanning it means
+ * reading the header of every sprite in the file.
+ */
+static std::map<std::array<uint8, 16>, GrfSpriteOffsetMap> _grf_sprite_offsets_cache;
+
+/** Sprite offsets of the current GRF. */
+static const GrfSpriteOffsetMap *_grf_sprite_offsets = &_grf_sprite_offsets_uncached;
+
+/**
+ * Drop cached sprite offsets of GRFs.
+ * @param keep List of GRFs of which the cached sprite offsets are kept, or nullptr to drop all of them, e.g. when the GRFs are reloaded from disk.
+ */
+void ClearGRFSpriteOffsetsCache(const GRFConfig *keep)
+{
+	_grf_sprite_offsets_uncached.clear();
+	_grf_sprite_offsets = &_grf_sprite_offsets_uncached;
+
+	for (auto iter = _grf_sprite_offsets_cache.begin(); iter != _grf_sprite_offsets_cache.end();) {
+		bool used = false;
+		for (const GRFConfig *c = keep; c != nullptr; c = c->next) {
+			if (std::equal(iter->first.begin(), iter->first.end(), c->ident.md5sum)) {
+				used = true;
+				break;
+			}
+		}
+		if (used) {
+			++iter;
+		} else {
+			iter = _grf_sprite_offsets_cache.erase(iter);
+		}
+	}
+}
 
 /**
  * Get the file offset for a specific sprite in the sprite section of a GRF.
@@ -601,21 +642,37 @@ static btree::btree_map<uint32, GrfSpriteOffset> _grf_sprite_offsets;
  */
 size_t GetGRFSpriteOffset(uint32 id)
 {
-	auto iter = _grf_sprite_offsets.find(id);
-	return iter != _grf_sprite_offsets.end() ? iter->second.file_pos : SIZE_MAX;
+	auto iter = _grf_sprite_offsets->find(id);
+	return iter != _grf_sprite_offsets->end() ? iter->second.file_pos : SIZE_MAX;
 }
 
 /**
  * Parse the sprite section of GRFs.
- * @param container_version Container version of the GRF we're currently processing.
+ * @param file GRF we're currently processing.
+ * @param md5sum MD5 sum of the GRF, if known. The sprite section of a GRF with a known MD5 sum is only parsed once.
  */
-void ReadGRFSpriteOffsets(SpriteFile &file)
+void ReadGRFSpriteOffsets(SpriteFile &file, const uint8 *md5sum)
 {
-	_grf_sprite_offsets.clear();
+	_grf_sprite_offsets_uncached.clear();
+	_grf_sprite_offsets = &_grf_sprite_offsets_uncached;
 
 	if (file.GetContainerVersion() >= 2) {
 		/* Seek to sprite section of the GRF. */
 		size_t data_offset = file.ReadDword();
+
+		GrfSpriteOffsetMap *offsets = &_grf_sprite_offsets_uncached;
+		if (md5sum != nullptr && std::any_of(md5sum, md5sum + 16, [](uint8 b) { return b != 0; })) {
+			std::array<uint8, 16> key;
+			std::copy(md5sum, md5sum + 16, key.begin());
+			auto iter = _grf_sprite_offsets_cache.find(key);
+			if (iter != _grf_sprite_offsets_cache.end()) {
+				_grf_sprite_offsets = &iter->second;
+				return;
+			}
+			offsets = &_grf_sprite_offsets_cache[key];
+			_grf_sprite_offsets = offsets;
+		}
+
 		size_t old_pos = file.GetPos();
 		file.SeekTo(data_offset, SEEK_CUR);
 
@@ -626,7 +683,7 @@ void ReadGRFSpriteOffsets(SpriteFile &file)
 		uint32 id, prev_id = 0;
 		while ((id = file.ReadDword()) != 0) {
 			if (id != prev_id) {
-				_grf_sprite_offsets[prev_id] = offset;
+				(*offsets)[prev_id] = offset;
 				offset.file_pos = file.GetPos() - 4;
 				offset.count = 0;
 				offset.has_non_palette = false;
@@ -640,7 +697,7 @@ void ReadGRFSpriteOffsets(SpriteFile &file)
 			}
 			file.SkipBytes(length);
 		}
-		if (prev_id != 0) _grf_sprite_offsets[prev_id] = offset;
+		if (prev_id != 0) (*offsets)[prev_id] = offset;
 
 		/* Continue processing the data section. */
 		file.SeekTo(old_pos, SEEK_SET);
@@ -687,8 +744,8 @@ bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id)
 			return false;
 		}
 		/* It is not an error if no sprite with the provided ID is found in the sprite section. */
-		auto iter = _grf_sprite_offsets.find(file.ReadDword());
-		if (iter != _grf_sprite_offsets.end()) {
+		auto iter = _grf_sprite_offsets->find(file.ReadDword());
+		if (iter != _grf_sprite_offsets->end()) {
 			file_pos = iter->second.file_pos;
 			count = iter->second.count;
 			has_non_palette = iter->second.has_non_palette;
@@ -13,6 +13,8 @@
 #include "gfx_type.h"
 #include "spriteloader/spriteloader.hpp"
 
+struct GRFConfig;
+
 /** Data structure describing a sprite. */
 struct Sprite {
 	uint16 height; ///< Height of the sprite.
@@ -55,7 +57,8 @@ void IncreaseSpriteLRU();
 
 SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
 
-void ReadGRFSpriteOffsets(SpriteFile &file);
+void ClearGRFSpriteOffsetsCache(const GRFConfig *keep);
+void ReadGRFSpriteOffsets(SpriteFile &file, const uint8 *md5sum = nullptr);
 size_t GetGRFSpriteOffset(uint32 id);
 bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id);
 bool SkipSpriteData(SpriteFile &file, byte type, uint16 num);
@@ -1613,9 +1613,9 @@ CommandCost CmdBuildRailStation(TileIndex tile_org, DoCommandFlag flags, uint32
 				tile += tile_delta;
 			} while (--w);
 			AddTrackToSignalBuffer(tile_track, track, _current_company);
-			YapfNotifyTrackLayoutChange(tile_track, track);
 			tile_track += tile_delta ^ TileDiffXY(1, 1); // perpendicular to tile_delta
 		} while (--numtracks);
+		YapfNotifyTrackLayoutAreaChange(new_location);
 
 		for (uint i = 0; i < affected_vehicles.size(); ++i) {
 			/* Restore reservations of trains. */
@@ -4161,7 +4161,8 @@ void DeleteStaleLinks(Station *from)
 								LinkRefresher::Run(v, false); // Don't allow merging. Otherwise lg might get deleted.
 							}
 						}
-						if (edge.LastUpdate() == _date) {
+						/* Refreshing may have added edges, so look the edge up again. */
+						if ((*lg)[ge.node][to->goods[c].node].LastUpdate() == _date) {
 							updated = true;
 							break;
 						}
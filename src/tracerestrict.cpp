@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <memory>
 
 #include "safeguards.h"
 
@@ -114,10 +115,58 @@ enum TraceRestrictCondStackFlags {
 };
 DECLARE_ENUM_AS_BIT_SET(TraceRestrictCondStackFlags)
 
+/**
+ * Condition stack used for program execution.
+ * The maximum depth of a compiled program is known, so the stack is stored inline for all but very deeply nested programs.
+ */
+class TraceRestrictCondStack {
+	static const size_t INLINE_SIZE = 16;
+
+	TraceRestrictCondStackFlags inline_buffer[INLINE_SIZE];
+	std::unique_ptr<TraceRestrictCondStackFlags[]> heap_buffer;
+	TraceRestrictCondStackFlags *buffer;
+	size_t count = 0;
+	size_t capacity;
+
+public:
+	TraceRestrictCondStack(size_t max_depth)
+	{
+		if (max_depth > INLINE_SIZE) {
+			this->heap_buffer.reset(new TraceRestrictCondStackFlags[max_depth]);
+			this->buffer = this->heap_buffer.get();
+			this->capacity = max_depth;
+		} else {
+			this->buffer = this->inline_buffer;
+			this->capacity = INLINE_SIZE;
+		}
+	}
+
+	bool empty() const { return this->count == 0; }
+
+	TraceRestrictCondStackFlags &back()
+	{
+		assert(this->count > 0);
+		return this->buffer[this->count - 1];
+	}
+
+	void push_back(TraceRestrictCondStackFlags flags)
+	{
+		assert(this->count < this->capacity);
+		this->buffer[this->count++] = flags;
+	}
+
+	void pop_back()
+	{
+		assert(this->count > 0);
+		this->count--;
+	}
+};
+
 /**
  * Helper function to handle condition stack manipulatoin
  */
-static void HandleCondition(std::vector<TraceRestrictCondStackFlags> &condstack, TraceRestrictCondFlags condflags, bool value)
+template <typename T>
+static void HandleCondition(T &condstack, TraceRestrictCondFlags condflags, bool value)
 {
 	if (condflags & TRCF_OR) {
 		assert(!condstack.empty());
@@ -240,14 +289,15 @@ static bool TestStationCondition(StationID station, TraceRestrictItem item)
  */
 void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
 {
-	// static to avoid needing to re-alloc/resize on each execution
-	static std::vector<TraceRestrictCondStackFlags> condstack;
-	condstack.clear();
+	size_t size = this->items.size();
+
+	/* If the program is compiled, inactive branches are skipped using the precomputed offsets. */
+	const bool compiled = this->cond_skip_offsets.size() == size;
+	TraceRestrictCondStack condstack(compiled ? this->max_cond_depth : size);
 
 	byte have_previous_signal = 0;
 	TileIndex previous_signal_tile[2];
 
-	size_t size = this->items.size();
 	for (size_t i = 0; i < size; i++) {
 		TraceRestrictItem item = this->items[i];
 		TraceRestrictItemType type = GetTraceRestrictType(item);
@@ -255,6 +305,7 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 		if (IsTraceRestrictConditional(item)) {
 			TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
 			TraceRestrictCondOp condop = GetTraceRestrictCondOp(item);
+			const size_t item_offset = i;
 
 			if (type == TRIT_COND_ENDIF) {
 				assert(!condstack.empty());
@@ -263,10 +314,16 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 					assert(!(condstack.back() & TRCSF_SEEN_ELSE));
 					HandleCondition(condstack, condflags, true);
 					condstack.back() |= TRCSF_SEEN_ELSE;
+					if (compiled && !(condstack.back() & TRCSF_ACTIVE)) i = this->cond_skip_offsets[item_offset] - 1;
 				} else {
 					// end if
 					condstack.pop_back();
 				}
+			} else if ((condflags & (TRCF_OR | TRCF_ELSE)) && (condstack.back() & (TRCSF_DONE_IF | TRCSF_PARENT_INACTIVE))) {
+				/* The result of an or-if/else-if is not used when the branch is already done (or active), or the parent is inactive */
+				if (IsTraceRestrictDoubleItem(item)) i++;
+				HandleCondition(condstack, condflags, false);
+				if (compiled && !(condstack.back() & TRCSF_ACTIVE)) i = this->cond_skip_offsets[item_offset] - 1;
 			} else {
 				uint16 condvalue = GetTraceRestrictValue(item);
 				bool result = false;
@@ -570,6 +627,7 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 						NOT_REACHED();
 				}
 				HandleCondition(condstack, condflags, result);
+				if (compiled && !(condstack.back() & TRCSF_ACTIVE)) i = this->cond_skip_offsets[item_offset] - 1;
 			}
 		} else {
 			if (condstack.empty() || condstack.back() & TRCSF_ACTIVE) {
@@ -782,6 +840,48 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 	assert(condstack.empty());
 }
 
+/**
+ * Compile the program: precompute the offsets used to skip inactive branches and the maximum condition depth.
+ * The program must be valid.
+ */
+void TraceRestrictProgram::Compile()
+{
+	const size_t size = this->items.size();
+	this->cond_skip_offsets.assign(size, 0);
+	this->max_cond_depth = 0;
+
+	/* Array offset of the if/elif/orif/else item which started the current branch, at each nesting level */
+	std::vector<uint32> branch_start;
+
+	for (size_t i = 0; i < size; i++) {
+		TraceRestrictItem item = this->items[i];
+
+		if (IsTraceRestrictConditional(item)) {
+			TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
+
+			if (GetTraceRestrictType(item) == TRIT_COND_ENDIF) {
+				assert(!branch_start.empty());
+				this->cond_skip_offsets[branch_start.back()] = (uint32)i;
+				if (condflags & TRCF_ELSE) {
+					branch_start.back() = (uint32)i;
+				} else {
+					branch_start.pop_back();
+				}
+			} else if (condflags & (TRCF_OR | TRCF_ELSE)) {
+				assert(!branch_start.empty());
+				this->cond_skip_offsets[branch_start.back()] = (uint32)i;
+				branch_start.back() = (uint32)i;
+			} else {
+				branch_start.push_back((uint32)i);
+				this->max_cond_depth = std::max<uint32>(this->max_cond_depth, (uint32)branch_start.size());
+			}
+		}
+
+		if (IsTraceRestrictDoubleItem(item)) i++;
+	}
+	assert(branch_start.empty());
+}
+
 /**
  * Decrement ref count, only use when removing a mapping
  */
@@ -1578,6 +1678,7 @@ CommandCost CmdProgramSignalTraceRestrict(TileIndex tile, DoCommandFlag flags, u
 		// move in modified program
 		prog->items.swap(items);
 		prog->actions_used_flags = actions_used_flags;
+		prog->Compile();
 
 		if (prog->items.size() == 0 && prog->refcount == 1) {
 			// program is empty, and this tile is the only reference to it
@@ -465,11 +465,20 @@ struct TraceRestrictProgram : TraceRestrictProgramPool::PoolItem<&_tracerestrict
 	uint32 refcount;
 	TraceRestrictProgramActionsUsedFlags actions_used_flags;
 
+	/**
+	 * For each conditional item: array offset of the next else/elif/orif/endif item at the same nesting level.
+	 * This is used to skip inactive branches, it is empty if the program has not been compiled.
+	 */
+	std::vector<uint32> cond_skip_offsets;
+	uint32 max_cond_depth = 0; ///< Maximum conditional nesting depth of the compiled program
+
 	TraceRestrictProgram()
 			: refcount(0), actions_used_flags(static_cast<TraceRestrictProgramActionsUsedFlags>(0)) { }
 
 	void Execute(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
 
+	void Compile();
+
 	/**
 	 * Increment ref count, only use when creating a mapping
 	 */
@@ -519,10 +528,16 @@ struct TraceRestrictProgram : TraceRestrictProgramPool::PoolItem<&_tracerestrict
 		return items.begin() + TraceRestrictProgram::InstructionOffsetToArrayOffset(items, instruction_offset);
 	}
 
-	/** Call validation function on current program instruction list and set actions_used_flags */
+	/** Call validation function on current program instruction list and set actions_used_flags, compile the program if it is valid */
 	CommandCost Validate()
 	{
-		return TraceRestrictProgram::Validate(items, actions_used_flags);
+		CommandCost result = TraceRestrictProgram::Validate(items, actions_used_flags);
+		if (result.Succeeded()) {
+			this->Compile();
+		} else {
+			this->cond_skip_offsets.clear();
+		}
+		return result;
 	}
 };
 
@@ -461,25 +461,60 @@ byte VehicleRandomBits()
 	return GB(Random(), 0, 8);
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
+/* Maximum size of the hash along each axis, 9 = 512 x 512. The hash is sized to the map
+ * up to this limit, so on smaller maps every tile gets its own bucket. Larger sizes will
+ * (in theory) reduce hash lookup times at the expense of memory usage. */
+static const uint MAX_HASH_BITS = 9;
 
 /* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
  * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
+static const uint HASH_RES = 0;
 
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE * 4];
+static uint _vehicle_tile_hash_bits_x;     ///< Number of bits of the tile X coordinate used by the tile hash.
+static uint _vehicle_tile_hash_bits_y;     ///< Number of bits of the tile Y coordinate used by the tile hash.
+static uint _vehicle_tile_hash_size;       ///< Number of buckets in the tile hash, per vehicle type.
+static std::vector<Vehicle *> _vehicle_tile_hash; ///< Tile location hash, #_vehicle_tile_hash_size buckets for each of the 4 company vehicle types.
 
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
+/**
+ * Get the tile hash bucket X part for a tile X coordinate.
+ * @param x Tile X coordinate, may be out of range of the map.
+ * @return X part of the bucket index.
+ */
+static inline uint GetVehicleTileHashX(int x)
+{
+	return GB(x, HASH_RES, _vehicle_tile_hash_bits_x);
+}
+
+/**
+ * Get the tile hash bucket Y part for a tile Y coordinate.
+ * @param y Tile Y coordinate, may be out of range of the map.
+ * @return Y part of the bucket index.
+ */
+static inline uint GetVehicleTileHashY(int y)
+{
+	return GB(y, HASH_RES, _vehicle_tile_hash_bits_y) << _vehicle_tile_hash_bits_x;
+}
+
+/**
+ * Get the tile hash bucket for a given hash position and vehicle type.
+ * @param x X part of the bucket index.
+ * @param y Y part of the bucket index.
+ * @param type Vehicle type.
+ * @return Pointer to the head of the bucket.
+ */
+static inline Vehicle **GetVehicleTileHashBucket(uint x, uint y, VehicleType type)
 {
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * type)];
+	return &_vehicle_tile_hash[x + y + (_vehicle_tile_hash_size * type)];
+}
+
+static Vehicle *VehicleFromTileHash(uint xl, uint yl, uint xu, uint yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	const uint x_mask = (1 << _vehicle_tile_hash_bits_x) - 1;
+	const uint y_mask = ((1 << _vehicle_tile_hash_bits_y) - 1) << _vehicle_tile_hash_bits_x;
+
+	for (uint y = yl; ; y = (y + (1 << _vehicle_tile_hash_bits_x)) & y_mask) {
+		for (uint x = xl; ; x = (x + 1) & x_mask) {
+			Vehicle *v = *GetVehicleTileHashBucket(x, y, type);
 			for (; v != nullptr; v = v->hash_tile_next) {
 				Vehicle *a = proc(v, data);
 				if (find_first && a != nullptr) return a;
@@ -509,10 +544,10 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
 	const int COLL_DIST = 6;
 
 	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
+	uint xl = GetVehicleTileHashX((x - COLL_DIST) / TILE_SIZE);
+	uint xu = GetVehicleTileHashX((x + COLL_DIST) / TILE_SIZE);
+	uint yl = GetVehicleTileHashY((y - COLL_DIST) / TILE_SIZE);
+	uint yu = GetVehicleTileHashY((y + COLL_DIST) / TILE_SIZE);
 
 	return VehicleFromTileHash(xl, yl, xu, yu, type, data, proc, find_first);
 }
@@ -529,10 +564,7 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
  */
 Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
-
-	Vehicle *v = _vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * type)];
+	Vehicle *v = *GetVehicleTileHashBucket(GetVehicleTileHashX(TileX(tile)), GetVehicleTileHashY(TileY(tile)), type);
 	for (; v != nullptr; v = v->hash_tile_next) {
 		if (v->tile != tile) continue;
 
@@ -831,9 +863,7 @@ void UpdateVehicleTileHash(Vehicle *v, bool remove)
 	if (remove || HasBit(v->subtype, GVSF_VIRTUAL)) {
 		new_hash = nullptr;
 	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * v->type)];
+		new_hash = GetVehicleTileHashBucket(GetVehicleTileHashX(TileX(v->tile)), GetVehicleTileHashY(TileY(v->tile)), v->type);
 	}
 
 	if (old_hash == new_hash) return;
@@ -860,9 +890,30 @@ bool ValidateVehicleTileHash(const Vehicle *v)
 {
 	if ((v->type == VEH_TRAIN && Train::From(v)->IsVirtual()) || v->type >= VEH_COMPANY_END) return v->hash_tile_current == nullptr;
 
-	int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-	return v->hash_tile_current == &_vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * v->type)];
+	return v->hash_tile_current == GetVehicleTileHashBucket(GetVehicleTileHashX(TileX(v->tile)), GetVehicleTileHashY(TileY(v->tile)), v->type);
+}
+
+/**
+ * Get statistics about the occupancy of the vehicle tile hash.
+ * @param[out] used_buckets Number of non-empty buckets.
+ * @param[out] total_vehicles Number of vehicles in the hash.
+ * @param[out] max_chain Length of the longest chain.
+ * @return Total number of buckets.
+ */
+uint GetVehicleTileHashStats(uint &used_buckets, uint &total_vehicles, uint &max_chain)
+{
+	used_buckets = 0;
+	total_vehicles = 0;
+	max_chain = 0;
+	for (const Vehicle *head : _vehicle_tile_hash) {
+		if (head == nullptr) continue;
+		uint chain = 0;
+		for (const Vehicle *v = head; v != nullptr; v = v->hash_tile_next) chain++;
+		used_buckets++;
+		total_vehicles += chain;
+		max_chain = std::max(max_chain, chain);
+	}
+	return (uint)_vehicle_tile_hash.size();
 }
 
 static Vehicle *_vehicle_viewport_hash[1 << (GEN_HASHX_BITS + GEN_HASHY_BITS)];
@@ -940,7 +991,13 @@ void ResetVehicleHash()
 {
 	for (Vehicle *v : Vehicle::Iterate()) { v->hash_tile_current = nullptr; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+
+	/* Size the tile hash to the current map, so that tiles only share a bucket when the map is larger than the hash. */
+	_vehicle_tile_hash_bits_x = std::min(MapLogX() - HASH_RES, MAX_HASH_BITS);
+	_vehicle_tile_hash_bits_y = std::min(MapLogY() - HASH_RES, MAX_HASH_BITS);
+	_vehicle_tile_hash_size = 1 << (_vehicle_tile_hash_bits_x + _vehicle_tile_hash_bits_y);
+	_vehicle_tile_hash.assign(_vehicle_tile_hash_size * 4, nullptr);
+	_vehicle_tile_hash.shrink_to_fit();
 }
 
 void ResetVehicleColourMap()
@@ -1441,7 +1498,10 @@ void VehicleTickMotion(Vehicle *v, Vehicle *front)
 	if (v->vehstatus & VS_HIDDEN) return;
 
 	v->motion_counter += front->cur_speed;
-	if (_settings_client.sound.vehicle) {
+
+	/* Motion sounds go through the NewGRF sound callback for every moving vehicle part,
+	 * skip resolving it entirely when nothing can be heard (e.g. on a dedicated server). */
+	if (_settings_client.sound.vehicle && _settings_client.music.effect_vol != 0 && !_network_dedicated) {
 		/* Play a running sound if the motion counter passes 256 (Do we not skip sounds?) */
 		if (GB(v->motion_counter, 0, 8) < front->cur_speed) PlayVehicleSound(v, VSE_RUNNING);
 
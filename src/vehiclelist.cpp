@@ -124,8 +124,27 @@ bool GenerateVehicleSortList(VehicleList *list, const VehicleListIdentifier &vli
 		}
 	};
 
+	/* Use the order destination index to visit only the order lists which go to the destination,
+	 * fall back to scanning all vehicles when it is not available. */
+	auto fill_order_destination_vehicles = [&](bool depot) -> bool {
+		if (!_order_destination_refcount_map_valid) return false;
+		IterateOrderListsForDestination(vli.index, depot, [&](OrderListID list_id) {
+			const Vehicle *v = OrderList::Get(list_id)->GetFirstSharedVehicle();
+			if (v == nullptr || v->type != vli.vtype || !v->IsPrimaryVehicle()) return;
+			for (; v != nullptr; v = v->NextShared()) {
+				list->push_back(v);
+			}
+		});
+		/* Keep the same order as the vehicle pool scan */
+		std::sort(list->begin(), list->end(), [](const Vehicle *a, const Vehicle *b) {
+			return a->index < b->index;
+		});
+		return true;
+	};
+
 	switch (vli.type) {
 		case VL_STATION_LIST:
+			if (fill_order_destination_vehicles(false)) break;
 			for (const Vehicle *v : Vehicle::Iterate()) {
 				if (v->type == vli.vtype && v->IsPrimaryVehicle()) {
 					for (const Order *order : v->Orders()) {
@@ -168,6 +187,7 @@ bool GenerateVehicleSortList(VehicleList *list, const VehicleListIdentifier &vli
 			break;
 
 		case VL_DEPOT_LIST:
+			if (fill_order_destination_vehicles(true)) break;
 			for (const Vehicle *v : Vehicle::Iterate()) {
 				if (v->type == vli.vtype && v->IsPrimaryVehicle()) {
 					for (const Order *order : v->Orders()) {
@@ -110,11 +110,18 @@
 #include "scope.h"
 #include "blitter/32bpp_base.hpp"
 
+#include "thread.h"
+
 #include <map>
 #include <vector>
 #include <math.h>
 #include <algorithm>
 #include <tuple>
+#include <atomic>
+#include <condition_variable>
+#if defined(__MINGW32__)
+#include "3rdparty/mingw-std-threads/mingw.condition_variable.h"
+#endif
 
 #include "table/strings.h"
 #include "table/string_colours.h"
@@ -378,6 +385,49 @@ void ClearViewportLandPixelCache(Viewport *vp)
 	vp->land_pixel_cache.assign(vp->land_pixel_cache.size(), 0xD7);
 }
 
+/**
+ * Move the contents of the land pixel cache of a map mode viewport along with the viewport being scrolled,
+ * such that only the newly exposed parts have to be recomputed.
+ * @param vp Viewport being scrolled.
+ * @param xo Number of pixels the contents move to the right.
+ * @param yo Number of pixels the contents move down.
+ */
+static void ScrollViewportLandPixelCache(Viewport *vp, int xo, int yo)
+{
+	if (vp->land_pixel_cache.empty()) return;
+	if (abs(xo) >= vp->width || abs(yo) >= vp->height) {
+		ClearViewportLandPixelCache(vp);
+		return;
+	}
+
+	const size_t bytes_per_pixel = vp->land_pixel_cache.size() / ((size_t)vp->width * vp->height);
+	const size_t row_size = vp->width * bytes_per_pixel;
+	const size_t copy_size = (vp->width - abs(xo)) * bytes_per_pixel;
+	const size_t fill_size = abs(xo) * bytes_per_pixel;
+	uint8 *data = vp->land_pixel_cache.data();
+
+	auto move_row = [&](int y) {
+		uint8 *dst = data + y * row_size;
+		const uint8 *src = data + (y - yo) * row_size;
+		if (xo >= 0) {
+			memmove(dst + fill_size, src, copy_size);
+			memset(dst, 0xD7, fill_size);
+		} else {
+			memmove(dst, src + fill_size, copy_size);
+			memset(dst + copy_size, 0xD7, fill_size);
+		}
+	};
+
+	/* Move the rows in an order such that no row is overwritten before it has been moved. */
+	if (yo > 0) {
+		for (int y = vp->height - 1; y >= yo; y--) move_row(y);
+		memset(data, 0xD7, yo * row_size);
+	} else {
+		for (int y = 0; y < vp->height + yo; y++) move_row(y);
+		memset(data + (vp->height + yo) * row_size, 0xD7, -yo * row_size);
+	}
+}
+
 void ClearViewportCache(Viewport *vp)
 {
 	if (vp->zoom >= ZOOM_LVL_DRAW_MAP) {
@@ -727,7 +777,7 @@ static void SetViewportPosition(Window *w, int x, int y, bool force_update_overl
 		if (i >= 0) height -= i;
 
 		if (height > 0 && (_vp_move_offs.x != 0 || _vp_move_offs.y != 0)) {
-			ClearViewportLandPixelCache(vp);
+			ScrollViewportLandPixelCache(vp, _vp_move_offs.x, _vp_move_offs.y);
 			SCOPE_INFO_FMT([&], "DoSetViewportPosition: %d, %d, %d, %d, %d, %d, %s", left, top, width, height, _vp_move_offs.x, _vp_move_offs.y, scope_dumper().WindowInfo(w));
 			w->viewport->update_vehicles = true;
 			DoSetViewportPosition((Window *) w->z_front, left, top, width, height);
@@ -3179,81 +3229,211 @@ void ViewportMapDraw(Viewport * const vp)
 	}
 }
 
-static void ViewportProcessParentSprites()
-{
-	if (_vd.parent_sprites_to_sort.size() > 60 && (_cur_dpi->width >= 256 || _cur_dpi->height >= 256) && !_draw_bounding_boxes && !HasBit(_viewport_debug_flags, VDF_DISABLE_DRAW_SPLIT)) {
-		/* split drawing region */
-		ParentSpriteToSortVector all_sprites = std::move(_vd.parent_sprites_to_sort);
-		_vd.parent_sprites_to_sort.clear();
-		void *saved_dst_ptr = _cur_dpi->dst_ptr;
-		if (_cur_dpi->height > _cur_dpi->width) {
-			/* vertical split: upper half */
-			const int orig_height = _cur_dpi->height;
-			const int orig_top = _cur_dpi->top;
-			_cur_dpi->height = (orig_height / 2) & ScaleByZoom(-1, _cur_dpi->zoom);
-			int split = _cur_dpi->top + _cur_dpi->height;
-			for (ParentSpriteToDraw *psd : all_sprites) {
-				if (psd->top < split) _vd.parent_sprites_to_sort.push_back(psd);
-			}
-			ViewportProcessParentSprites();
-			_vd.parent_sprites_to_sort.clear();
+uint _viewport_sprite_sort_threads = 1; ///< number of threads to sort the parent sprites of split drawing regions with, 0 for one per CPU
 
-			/* vertical split: lower half */
-			_cur_dpi->dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(_cur_dpi->dst_ptr, 0, UnScaleByZoom(_cur_dpi->height, _cur_dpi->zoom));
-			_cur_dpi->top = split;
-			_cur_dpi->height = orig_height - _cur_dpi->height;
+/** Part of a split drawing region, of which the parent sprites are sorted and drawn separately. */
+struct ViewportSortRegion {
+	DrawPixelInfo dpi;                      ///< Drawing area of this part.
+	ParentSpriteToSortVector sprites;       ///< Parent sprites overlapping this part.
+	std::vector<ParentSpriteToDraw> copies; ///< Own copies of the parent sprites, when sorted on a worker thread.
+};
 
-			for (ParentSpriteToDraw *psd : all_sprites) {
-				psd->SetComparisonDone(false);
-				if (psd->top + psd->height > _cur_dpi->top) {
-					_vd.parent_sprites_to_sort.push_back(psd);
-				}
-			}
-			ViewportProcessParentSprites();
+/**
+ * Worker threads which sort the parent sprites of the parts of a split drawing region.
+ * The drawing thread takes part in the sorting as well, and draws the parts in order afterwards.
+ */
+class ViewportSortWorkers {
+	std::vector<std::thread> threads;
+	std::mutex lock;
+	std::condition_variable work_available;
+	std::condition_variable work_done;
+	std::vector<ViewportSortRegion> *regions = nullptr; ///< Regions currently being sorted.
+	std::atomic<uint> next_region;                      ///< Index of the next region to sort.
+	uint busy = 0;                                      ///< Number of worker threads not done with the current regions.
+	uint generation = 0;                                ///< Incremented for each set of regions.
+	bool exit = false;
+
+	/** Sort regions until none are left. */
+	void SortRegions()
+	{
+		for (uint i = this->next_region++; i < this->regions->size(); i = this->next_region++) {
+			_vp_sprite_sorter(&(*this->regions)[i].sprites);
+		}
+	}
 
-			/* restore _cur_dpi */
-			_cur_dpi->height = orig_height;
-			_cur_dpi->top = orig_top;
+	void Run(uint last_generation)
+	{
+		std::unique_lock<std::mutex> guard(this->lock);
+		for (;;) {
+			this->work_available.wait(guard, [&]() { return this->exit || this->generation != last_generation; });
+			if (this->exit) return;
+			last_generation = this->generation;
+
+			guard.unlock();
+			this->SortRegions();
+			guard.lock();
+
+			if (--this->busy == 0) this->work_done.notify_one();
+		}
+	}
+
+public:
+	~ViewportSortWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->exit = true;
+		}
+		this->work_available.notify_all();
+		for (std::thread &thread : this->threads) thread.join();
+	}
+
+	/**
+	 * Start worker threads, so that including the calling thread the requested number of threads is available.
+	 * @return The number of worker threads.
+	 */
+	uint Prepare()
+	{
+		uint count = _viewport_sprite_sort_threads != 0 ? _viewport_sprite_sort_threads : std::max<uint>(1, std::thread::hardware_concurrency());
+		while (this->threads.size() + 1 < count) {
+			std::thread thread;
+			const uint generation = this->generation;
+			if (!StartNewThread(&thread, "ottd:vp-sort", [this, generation]() { this->Run(generation); })) break;
+			this->threads.push_back(std::move(thread));
+		}
+		return (uint)this->threads.size();
+	}
+
+	/**
+	 * Sort the parent sprites of all regions, using the worker threads as well as the calling thread.
+	 * @param regions Regions to sort, their sprites must not be shared between regions.
+	 */
+	void Sort(std::vector<ViewportSortRegion> &regions)
+	{
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->regions = &regions;
+			this->next_region = 0;
+			this->busy = (uint)this->threads.size();
+			this->generation++;
+		}
+		this->work_available.notify_all();
+
+		this->SortRegions();
+
+		std::unique_lock<std::mutex> guard(this->lock);
+		this->work_done.wait(guard, [&]() { return this->busy == 0; });
+		this->regions = nullptr;
+	}
+};
+
+static ViewportSortWorkers _vp_sort_workers;
+static std::vector<ViewportSortRegion> _vp_sort_regions;
+
+/**
+ * Split the drawing region into parts small enough to keep the sprite sorter fast.
+ * @param dpi Drawing area.
+ * @param sprites Parent sprites overlapping the drawing area.
+ * @param regions [out] Parts of the drawing area.
+ */
+static void ViewportSplitParentSprites(DrawPixelInfo dpi, ParentSpriteToSortVector &&sprites, std::vector<ViewportSortRegion> &regions)
+{
+	if (sprites.size() > 60 && (dpi.width >= 256 || dpi.height >= 256) && !_draw_bounding_boxes && !HasBit(_viewport_debug_flags, VDF_DISABLE_DRAW_SPLIT)) {
+		ParentSpriteToSortVector first_sprites;
+		ParentSpriteToSortVector second_sprites;
+		DrawPixelInfo second = dpi;
+		if (dpi.height > dpi.width) {
+			/* vertical split: upper and lower half */
+			dpi.height = (second.height / 2) & ScaleByZoom(-1, dpi.zoom);
+			const int split = dpi.top + dpi.height;
+			second.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(dpi.dst_ptr, 0, UnScaleByZoom(dpi.height, dpi.zoom));
+			second.top = split;
+			second.height -= dpi.height;
+
+			for (ParentSpriteToDraw *psd : sprites) {
+				if (psd->top < split) first_sprites.push_back(psd);
+				if (psd->top + psd->height > split) second_sprites.push_back(psd);
+			}
 		} else {
-			/* horizontal split: left half */
-			const int orig_width = _cur_dpi->width;
-			const int orig_left = _cur_dpi->left;
-			_cur_dpi->width = (orig_width / 2) & ScaleByZoom(-1, _cur_dpi->zoom);
-			const int margin = UnScaleByZoom(128, _cur_dpi->zoom); // Half tile (1 column) margin either side of split
-			const int split = _cur_dpi->left + _cur_dpi->width;
-			for (ParentSpriteToDraw *psd : all_sprites) {
-				if (psd->left < split + margin) _vd.parent_sprites_to_sort.push_back(psd);
+			/* horizontal split: left and right half */
+			dpi.width = (second.width / 2) & ScaleByZoom(-1, dpi.zoom);
+			const int margin = UnScaleByZoom(128, dpi.zoom); // Half tile (1 column) margin either side of split
+			const int split = dpi.left + dpi.width;
+			second.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(dpi.dst_ptr, UnScaleByZoom(dpi.width, dpi.zoom), 0);
+			second.left = split;
+			second.width -= dpi.width;
+
+			for (ParentSpriteToDraw *psd : sprites) {
+				if (psd->left < split + margin) first_sprites.push_back(psd);
+				if (psd->left + psd->width > split - margin) second_sprites.push_back(psd);
 			}
-			ViewportProcessParentSprites();
-			_vd.parent_sprites_to_sort.clear();
+		}
+		sprites.clear();
+		ViewportSplitParentSprites(dpi, std::move(first_sprites), regions);
+		ViewportSplitParentSprites(second, std::move(second_sprites), regions);
+	} else {
+		regions.push_back({ dpi, std::move(sprites), {} });
+	}
+}
 
-			/* horizontal split: right half */
-			_cur_dpi->dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(_cur_dpi->dst_ptr, UnScaleByZoom(_cur_dpi->width, _cur_dpi->zoom), 0);
-			_cur_dpi->left = split;
-			_cur_dpi->width = orig_width - _cur_dpi->width;
+/**
+ * Draw the sorted parent sprites of (a part of) the drawing region in _cur_dpi.
+ * @param psdv Sorted parent sprites.
+ */
+static void ViewportDrawSortedParentSprites(const ParentSpriteToSortVector *psdv)
+{
+	ViewportDrawParentSprites(psdv, &_vd.child_screen_sprites_to_draw);
 
-			for (ParentSpriteToDraw *psd : all_sprites) {
-				psd->SetComparisonDone(false);
-				if (psd->left + psd->width > _cur_dpi->left - margin) {
-					_vd.parent_sprites_to_sort.push_back(psd);
-				}
+	if (_draw_dirty_blocks && HasBit(_viewport_debug_flags, VDF_DIRTY_BLOCK_PER_SPLIT)) {
+		ViewportDrawDirtyBlocks();
+		++_dirty_block_colour;
+	}
+}
+
+static void ViewportProcessParentSprites()
+{
+	_vp_sort_regions.clear();
+	ViewportSplitParentSprites(*_cur_dpi, std::move(_vd.parent_sprites_to_sort), _vp_sort_regions);
+
+	if (_vp_sort_regions.size() == 1) {
+		/* Not split, sort in place so the sorted sprites are available for drawing bounding boxes. */
+		_vd.parent_sprites_to_sort = std::move(_vp_sort_regions[0].sprites);
+		_vp_sort_regions.clear();
+		_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+		ViewportDrawSortedParentSprites(&_vd.parent_sprites_to_sort);
+		return;
+	}
+
+	const DrawPixelInfo saved_dpi = *_cur_dpi;
+	if (_vp_sort_workers.Prepare() > 0) {
+		/* Sprites at the edges are in several regions, give each region its own copies to sort. */
+		for (ViewportSortRegion &region : _vp_sort_regions) {
+			region.copies.reserve(region.sprites.size());
+			for (ParentSpriteToDraw *&psd : region.sprites) {
+				region.copies.push_back(*psd);
+				psd = &region.copies.back();
 			}
-			ViewportProcessParentSprites();
+		}
+		_vp_sort_workers.Sort(_vp_sort_regions);
 
-			/* restore _cur_dpi */
-			_cur_dpi->width = orig_width;
-			_cur_dpi->left = orig_left;
+		for (ViewportSortRegion &region : _vp_sort_regions) {
+			*_cur_dpi = region.dpi;
+			ViewportDrawSortedParentSprites(&region.sprites);
 		}
-		_cur_dpi->dst_ptr = saved_dst_ptr;
 	} else {
-		_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		for (ViewportSortRegion &region : _vp_sort_regions) {
+			/* Sprites at the edges were already sorted as part of the previous region. */
+			for (ParentSpriteToDraw *psd : region.sprites) {
+				psd->SetComparisonDone(false);
+			}
+			_vp_sprite_sorter(&region.sprites);
 
-		if (_draw_dirty_blocks && HasBit(_viewport_debug_flags, VDF_DIRTY_BLOCK_PER_SPLIT)) {
-			ViewportDrawDirtyBlocks();
-			++_dirty_block_colour;
+			*_cur_dpi = region.dpi;
+			ViewportDrawSortedParentSprites(&region.sprites);
 		}
 	}
+	*_cur_dpi = saved_dpi;
+	_vp_sort_regions.clear();
 }
 
 void ViewportDoDraw(Viewport *vp, int left, int top, int right, int bottom)
@@ -3756,6 +3936,7 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, ViewportMarkDirtyFlags flags, int bridge_level_offset, int tile_height_override)
 {
+	InvalidateSmallMapTileColour(tile);
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - 31  * ZOOM_LVL_BASE,
@@ -3768,6 +3949,7 @@ void MarkTileDirtyByTile(TileIndex tile, ViewportMarkDirtyFlags flags, int bridg
 
 void MarkTileGroundDirtyByTile(TileIndex tile, ViewportMarkDirtyFlags flags)
 {
+	InvalidateSmallMapTileColour(tile);
 	int x = TileX(tile) * TILE_SIZE;
 	int y = TileY(tile) * TILE_SIZE;
 	Point top = RemapCoords(x, y, GetTileMaxPixelZ(tile));